@@ -0,0 +1,8 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// Number of global operator new calls since startup. AllocCounter.cpp
+// replaces the global allocation functions to keep this count, so it covers
+// std containers, std::string and SFML alike.
+uint64_t allocationCount();
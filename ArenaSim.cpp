@@ -0,0 +1,308 @@
+﻿#include "ArenaSim.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+static const Direction ALL_DIRECTIONS[4] = { Up, Down, Left, Right };
+static const size_t    FOOD_SAMPLE = 64;       // food items arenaBot() looks at
+
+ArenaSim::ArenaSim(uint64_t seed)
+    : rng(seed)
+    , freeCells(0)
+    , foods(0)
+{
+    reset(ArenaConfig());
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Board
+// ─────────────────────────────────────────────────────────────────────────────
+
+void ArenaSim::setCell(const Cell& c, ArenaCell kind, Direction link) {
+    const size_t id = index(c);
+    const ArenaCell was = ArenaCell(grid[id] & KIND_MASK);
+    if (was == ArenaEmpty) freeCells.erase(uint32_t(id));
+    if (was == ArenaFood)  foods.erase(uint32_t(id));
+    if (kind == ArenaEmpty) freeCells.insert(uint32_t(id));
+    if (kind == ArenaFood)  foods.insert(uint32_t(id));
+    grid[id] = uint8_t(kind | (link << LINK_SHIFT));
+}
+
+void ArenaSim::reset(const ArenaConfig& cfg) {
+    config = cfg;
+    config.columns = std::clamp(cfg.columns, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+    config.rows = std::clamp(cfg.rows, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+    config.agents = std::clamp(cfg.agents, 0, ArenaConfig::MAX_AGENTS);
+    config.food = std::max(cfg.food, 0);
+    config.startLength = std::max(cfg.startLength, 1);
+
+    if (cols != config.columns || rowCount != config.rows) {
+        cols = config.columns;
+        rowCount = config.rows;
+        const size_t cells = size_t(cols) * size_t(rowCount);
+        grid.assign(cells, ArenaWall);
+        owner.assign(cells, 0);
+        freeCells = FreeCellIndex(cells);
+        foods = FreeCellIndex(cells);
+    }
+
+    // Rebuilt in scan order, as SnakeSim::reset() does, so a seed gives the
+    // same round whatever was played before
+    freeCells.clear();
+    foods.clear();
+    for (int y = 0; y < rowCount; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            const bool border = x == 0 || y == 0 || x == cols - 1 || y == rowCount - 1;
+            grid[index({ x, y })] = border ? ArenaWall : ArenaEmpty;
+            if (!border) freeCells.insert(uint32_t(index({ x, y })));
+        }
+    }
+
+    const size_t n = size_t(config.agents);
+    heads.assign(n, Cell());
+    tails.assign(n, Cell());
+    dirs.assign(n, uint8_t(None));
+    lengths.assign(n, 0);
+    growth.assign(n, 0);
+    scores.assign(n, 0);
+    kills_.assign(n, 0);
+    deaths_.assign(n, 0);
+    respawnAt.assign(n, 0);
+    alive_.assign(n, 0);
+    events_.assign(n, ArenaEvNone);
+    targets.assign(n, Cell());
+    eats.assign(n, 0);
+    dies.assign(n, 0);
+    claims.clear();
+    claims.reserve(n);
+
+    ticks = 0;
+    for (int i = 0; i < config.agents; ++i) {
+        if (!spawn(i)) respawnAt[i] = config.respawnTicks;
+    }
+    topUpFood();
+}
+
+bool ArenaSim::spawn(int agent) {
+    // A few random free cells; the first with an empty neighbour to head
+    // for wins. A packed board leaves the agent waiting another round.
+    for (int attempt = 0; attempt < 16 && freeCells.size() > 0; ++attempt) {
+        const Cell c = cellOf(freeCells.at(rng.below(uint32_t(freeCells.size()))));
+        const uint32_t first = rng.below(4);
+        for (uint32_t k = 0; k < 4; ++k) {
+            const Direction d = ALL_DIRECTIONS[(first + k) % 4];
+            if (cellAt(advance(c, d)) != ArenaEmpty) continue;
+
+            setCell(c, ArenaBody);
+            owner[index(c)] = uint16_t(agent);
+            heads[agent] = c;
+            tails[agent] = c;
+            dirs[agent] = uint8_t(d);
+            lengths[agent] = 1;
+            growth[agent] = uint32_t(config.startLength - 1);
+            alive_[agent] = 1;
+            events_[agent] |= ArenaEvSpawned;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ArenaSim::kill(int agent) {
+    // Tail to head along the links; every other segment is left as food
+    Cell c = tails[agent];
+    for (uint32_t k = 0; k < lengths[agent]; ++k) {
+        const Direction link = Direction(grid[index(c)] >> LINK_SHIFT);
+        setCell(c, (k & 1) ? ArenaFood : ArenaEmpty);
+        c = advance(c, link);
+    }
+    alive_[agent] = 0;
+    lengths[agent] = 0;
+    respawnAt[agent] = ticks + uint64_t(config.respawnTicks);
+    ++deaths_[agent];
+    events_[agent] |= ArenaEvDied;
+}
+
+void ArenaSim::topUpFood() {
+    while (foods.size() < size_t(config.food) && freeCells.size() > 0) {
+        setCell(cellOf(freeCells.at(rng.below(uint32_t(freeCells.size())))), ArenaFood);
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Tick
+// ─────────────────────────────────────────────────────────────────────────────
+
+unsigned ArenaSim::step(const std::vector<Direction>& inputs) {
+    ++ticks;
+    const int n = agentCount();
+    std::fill(events_.begin(), events_.end(), uint8_t(ArenaEvNone));
+
+    // 1) Respawns, then every live agent picks its target cell
+    for (int i = 0; i < n; ++i) {
+        if (!alive_[i] && ticks >= respawnAt[i] && !spawn(i)) respawnAt[i] = ticks + 1;
+    }
+    for (int i = 0; i < n; ++i) {
+        if (!alive_[i]) continue;
+        const Direction d = i < int(inputs.size()) ? inputs[i] : None;
+        if (d != None && (d != opposite(Direction(dirs[i])) || lengths[i] == 1)) dirs[i] = uint8_t(d);
+        targets[i] = advance(heads[i], Direction(dirs[i]));
+        eats[i] = cellAt(targets[i]) == ArenaFood;
+        dies[i] = 0;
+    }
+
+    // 2) Collisions against the board before the tick. A tail moves out
+    //    of the way unless its snake is growing or eating this tick.
+    claims.clear();
+    for (int i = 0; i < n; ++i) {
+        if (!alive_[i]) continue;
+        const Cell t = targets[i];
+        const ArenaCell k = cellAt(t);
+        if (k == ArenaWall) {
+            dies[i] = 1;
+        }
+        else if (k == ArenaBody) {
+            const int o = owner[index(t)];
+            const bool leaving = t == tails[o] && growth[o] == 0 && !eats[o];
+            const bool headOn = o != i && targets[o] == heads[i] && t == heads[o];
+            if (!leaving || headOn) {
+                dies[i] = 1;
+                if (o != i && !headOn) ++kills_[o];
+            }
+        }
+        claims.push_back(uint64_t(index(t)) << 16 | uint64_t(i));
+    }
+
+    //    Heads arriving in the same cell all die
+    std::sort(claims.begin(), claims.end());
+    for (size_t a = 0; a < claims.size(); ) {
+        size_t b = a + 1;
+        while (b < claims.size() && (claims[b] >> 16) == (claims[a] >> 16)) ++b;
+        if (b - a > 1) {
+            for (size_t k = a; k < b; ++k) dies[claims[k] & 0xFFFF] = 1;
+        }
+        a = b;
+    }
+
+    // 3) Remove the dead, move every tail, then every head
+    for (int i = 0; i < n; ++i) {
+        if (alive_[i] && dies[i]) kill(i);
+    }
+    for (int i = 0; i < n; ++i) {
+        if (!alive_[i]) continue;
+        if (eats[i]) ++growth[i];
+        if (growth[i] > 0) {
+            --growth[i];
+            continue;
+        }
+        const Cell t = tails[i];
+        const Direction link = Direction(grid[index(t)] >> LINK_SHIFT);
+        setCell(t, ArenaEmpty);
+        tails[i] = advance(t, link);
+        --lengths[i];
+    }
+    unsigned all = ArenaEvNone;
+    for (int i = 0; i < n; ++i) {
+        if (alive_[i]) {
+            const Cell t = targets[i];
+            if (cellAt(t) == ArenaFood) {
+                // Food dropped this tick (not known before it) grows next tick
+                if (!eats[i]) ++growth[i];
+                scores[i] += 10;
+                events_[i] |= ArenaEvAte;
+            }
+            const Cell h = heads[i];
+            if (lengths[i] > 0) {
+                grid[index(h)] = uint8_t(ArenaBody | (dirs[i] << LINK_SHIFT));
+            }
+            else {
+                tails[i] = t;   // a one-cell snake's tail left with it
+            }
+            setCell(t, ArenaBody);
+            owner[index(t)] = uint16_t(i);
+            heads[i] = t;
+            ++lengths[i];
+        }
+        all |= events_[i];
+    }
+
+    topUpFood();
+    return all;
+}
+
+uint64_t ArenaSim::checksum() const {
+    // FNV-1a
+    uint64_t h = 0xCBF29CE484222325ull;
+    auto mix = [&](const void* data, size_t bytes) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < bytes; ++i) h = (h ^ p[i]) * 0x100000001B3ull;
+        };
+    mix(grid.data(), grid.size());
+    mix(&ticks, sizeof ticks);
+    for (size_t i = 0; i < heads.size(); ++i) {
+        const uint32_t fields[] = { uint32_t(heads[i].x), uint32_t(heads[i].y), dirs[i], lengths[i],
+                                    growth[i], scores[i], deaths_[i], alive_[i] };
+        mix(fields, sizeof fields);
+    }
+    Rng next = rng;     // the RNG's next output stands in for its state
+    const uint32_t r = next.next();
+    mix(&r, sizeof r);
+    return h;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Bot
+// ─────────────────────────────────────────────────────────────────────────────
+
+Direction arenaBot(const ArenaSim& arena, int agent, Rng& rng) {
+    const Cell head = arena.head(agent);
+    const Direction cur = arena.heading(agent);
+
+    // Nearest food (Manhattan) of all of it, or when there is so much that
+    // scanning it all would cost more than the sim, of a slice that stays
+    // the same from tick to tick (so the bot doesn't change its mind)
+    const size_t foodCount = arena.foodCount();
+    const size_t looks = std::min(foodCount, FOOD_SAMPLE);
+    const size_t first = foodCount > 0 ? size_t(agent) * FOOD_SAMPLE % foodCount : 0;
+    Cell target = head;
+    int nearest = -1;
+    for (size_t f = 0; f < looks; ++f) {
+        const Cell c = arena.food((first + f) % foodCount);
+        const int dist = std::abs(c.x - head.x) + std::abs(c.y - head.y);
+        if (nearest < 0 || dist < nearest) {
+            nearest = dist;
+            target = c;
+        }
+    }
+
+    auto open = [&](const Cell& c) {
+        const ArenaCell k = arena.cellAt(c);
+        return k == ArenaEmpty || k == ArenaFood;
+    };
+
+    Direction best = cur;
+    int bestCost = -1;
+    const uint32_t start = rng.below(4);   // random start so ties don't favour one side
+    for (uint32_t k = 0; k < 4; ++k) {
+        const Direction d = ALL_DIRECTIONS[(start + k) % 4];
+        if (d == opposite(cur) && arena.length(agent) > 1) continue;
+        const Cell next = advance(head, d);
+        if (!open(next)) continue;
+
+        // Distance to the food, plus penalties for a cell another head
+        // could also take and for one with no way on
+        int cost = std::abs(next.x - target.x) + std::abs(next.y - target.y);
+        int exits = 0;
+        for (Direction e : ALL_DIRECTIONS) {
+            const Cell beyond = advance(next, e);
+            if (beyond != head && arena.isHead(beyond)) cost += 1000;
+            exits += open(beyond) ? 1 : 0;
+        }
+        if (exits == 0) cost += 10000;
+        if (bestCost < 0 || cost < bestCost) {
+            best = d;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
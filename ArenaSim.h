@@ -0,0 +1,146 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Arena simulation
+//
+// Many snakes and many food items on one board, all moving on the same
+// tick. Built to keep hundreds of agents on a large board inside a frame:
+//
+//   - One shared grid holds everything that is on the board. A body cell
+//     stores its owner and the direction of the next segment towards the
+//     head, so the bodies need no per-snake buffers: moving a snake is one
+//     write at the head and one at the tail, at any length.
+//   - Per-agent state is a structure of arrays (heads, directions, lengths,
+//     scores, ...), so a pass over every agent touches only the fields it
+//     needs.
+//
+// Moves are simultaneous and resolved against the board as it was before
+// the tick: a snake may move into a tail that is leaving this tick, heads
+// meeting in one cell (or passing through each other) all die, and anything
+// else that is not empty or food kills. Dead snakes leave food on every
+// other cell of their body and come back after respawnTicks.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct ArenaConfig {
+    int columns = DEFAULT_COLUMNS;
+    int rows = DEFAULT_ROWS;
+    int agents = 8;                     // up to MAX_AGENTS
+    int food = 8;                       // food topped up to this many each tick
+    int respawnTicks = 25;
+    int startLength = 3;
+
+    static constexpr int MAX_AGENTS = 0xFFFF;
+};
+
+// What an arena cell holds (low bits of a grid byte)
+enum ArenaCell : uint8_t { ArenaEmpty, ArenaWall, ArenaFood, ArenaBody };
+
+// Per-agent flags from the last step()
+enum ArenaEvent : uint8_t {
+    ArenaEvNone = 0,
+    ArenaEvAte = 1 << 0,
+    ArenaEvDied = 1 << 1,
+    ArenaEvSpawned = 1 << 2,
+};
+
+class ArenaSim {
+public:
+    explicit ArenaSim(uint64_t seed = 1);
+
+    void reseed(uint64_t seed) { rng.reseed(seed); }
+
+    // New round: every agent spawns at a random free cell. The grid is only
+    // reallocated when the board size changes.
+    void reset(const ArenaConfig& config);
+
+    // One tick for every agent. `inputs[i]` steers agent i (None keeps its
+    // heading, reversing is ignored); it needs one entry per agent.
+    // Returns the union of the agents' ArenaEvent flags.
+    unsigned step(const std::vector<Direction>& inputs);
+
+    int      columns() const { return cols; }
+    int      rows() const { return rowCount; }
+    int      agentCount() const { return int(heads.size()); }
+    uint64_t tick() const { return ticks; }
+
+    ArenaCell cellAt(const Cell& c) const {
+        return inBounds(c) ? ArenaCell(grid[index(c)] & KIND_MASK) : ArenaWall;
+    }
+    // Agent whose body covers `c` (only meaningful on ArenaBody cells)
+    int  ownerAt(const Cell& c) const { return owner[index(c)]; }
+    bool isHead(const Cell& c) const { return cellAt(c) == ArenaBody && heads[owner[index(c)]] == c; }
+
+    // Food on the board, in no particular order
+    size_t foodCount() const { return foods.size(); }
+    Cell   food(size_t i) const { return cellOf(foods.at(i)); }
+
+    bool      alive(int agent) const { return alive_[agent] != 0; }
+    Cell      head(int agent) const { return heads[agent]; }
+    Direction heading(int agent) const { return Direction(dirs[agent]); }
+    uint32_t  length(int agent) const { return lengths[agent]; }
+    uint32_t  score(int agent) const { return scores[agent]; }
+    uint32_t  kills(int agent) const { return kills_[agent]; }
+    uint32_t  deaths(int agent) const { return deaths_[agent]; }
+    unsigned  events(int agent) const { return events_[agent]; }
+
+    // Hash of the board, the agents and the food RNG: two arenas that were
+    // reset with the same seed and stepped with the same inputs agree
+    uint64_t checksum() const;
+
+private:
+    static const uint8_t KIND_MASK = 0x07;
+    static const int     LINK_SHIFT = 3;   // Direction to the next segment towards the head
+
+    bool   inBounds(const Cell& c) const {
+        return c.x >= 0 && c.x < cols && c.y >= 0 && c.y < rowCount;
+    }
+    size_t index(const Cell& c) const { return size_t(c.y) * size_t(cols) + size_t(c.x); }
+    Cell   cellOf(uint32_t id) const { return { int(id % uint32_t(cols)), int(id / uint32_t(cols)) }; }
+
+    void setCell(const Cell& c, ArenaCell kind, Direction link = None);
+    bool spawn(int agent);
+    void kill(int agent);
+    void topUpFood();
+
+    ArenaConfig config;
+    Rng         rng;
+    int         cols = 0;
+    int         rowCount = 0;
+    uint64_t    ticks = 0;
+
+    // Shared board
+    std::vector<uint8_t>  grid;         // ArenaCell | link << LINK_SHIFT
+    std::vector<uint16_t> owner;        // agent id of each body cell
+    FreeCellIndex         freeCells;    // every ArenaEmpty cell
+    FreeCellIndex         foods;        // every ArenaFood cell
+
+    // Agents, structure of arrays (index = agent id)
+    std::vector<Cell>     heads;
+    std::vector<Cell>     tails;
+    std::vector<uint8_t>  dirs;         // Direction
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> growth;       // segments still to grow: the tail stays put
+    std::vector<uint32_t> scores;
+    std::vector<uint32_t> kills_;
+    std::vector<uint32_t> deaths_;
+    std::vector<uint64_t> respawnAt;    // tick a dead agent comes back
+    std::vector<uint8_t>  alive_;
+    std::vector<uint8_t>  events_;
+
+    // step() scratch, sized once per reset
+    std::vector<Cell>     targets;
+    std::vector<uint8_t>  eats;         // target held food before the tick
+    std::vector<uint8_t>  dies;
+    std::vector<uint64_t> claims;       // target index << 16 | agent, sorted
+};
+
+// Arena bot: heads for the nearest food (looking at 64 items at most),
+// avoiding cells that kill, cells next to another snake's head (a possible
+// head-on) and dead ends. One call per agent per tick; reads the arena
+// only, so calls can run in parallel for different agents.
+Direction arenaBot(const ArenaSim& arena, int agent, Rng& rng);
@@ -0,0 +1,183 @@
+﻿#include "AssetPack.h"
+
+#include "Util.h"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+// MappedFile
+// ─────────────────────────────────────────────────────────────────────────────
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    HANDLE m = nullptr;
+    if (GetFileSizeEx(f, &size) && size.QuadPart > 0) {
+        m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(f);                     // the mapping keeps the file open
+    if (!m) return false;
+
+    void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(m);
+        return false;
+    }
+    mapping = m;
+    bytes = static_cast<const uint8_t*>(view);
+    length = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mapping) CloseHandle(mapping);
+    bytes = nullptr;
+    mapping = nullptr;
+    length = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);                        // the mapping keeps the file open
+    if (view == MAP_FAILED) return false;
+
+    bytes = static_cast<const uint8_t*>(view);
+    length = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+}
+
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+// AssetPack
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool AssetPack::open(const std::string& path) {
+    entries.clear();
+    if (!file.open(path)) return false;
+
+    const uint8_t* p = file.data();
+    const size_t size = file.size();
+    bool valid = size >= 12 && p[0] == 'S' && p[1] == 'N' && p[2] == 'K' && p[3] == 'P' &&
+                 readLe(p + 4, 4) == ASSET_PACK_VERSION;
+    size_t at = 12;
+    uint64_t count = valid ? readLe(p + 8, 4) : 0;
+    for (uint64_t i = 0; valid && i < count; ++i) {
+        if (at + 2 > size) { valid = false; break; }
+        size_t nameLength = size_t(readLe(p + at, 2));
+        at += 2;
+        if (at + nameLength + 16 > size) { valid = false; break; }
+        Entry e;
+        e.name.assign(reinterpret_cast<const char*>(p + at), nameLength);
+        at += nameLength;
+        e.offset = readLe(p + at, 8);
+        e.size = readLe(p + at + 8, 8);
+        at += 16;
+        valid = e.offset <= size && e.size <= size - e.offset;
+        entries.push_back(std::move(e));
+    }
+
+    if (!valid) {
+        entries.clear();
+        file.close();
+    }
+    return valid;
+}
+
+const uint8_t* AssetPack::find(const std::string& name, size_t& size) const {
+    for (const Entry& e : entries) {
+        if (e.name == name) {
+            size = size_t(e.size);
+            return file.data() + e.offset;
+        }
+    }
+    size = 0;
+    return nullptr;
+}
+
+bool writeAssetPack(const std::string& path, const std::vector<std::string>& files,
+                    std::string& error)
+{
+    std::vector<std::vector<uint8_t>> contents;
+    std::vector<std::string> names;
+    for (const std::string& f : files) {
+        std::ifstream in(f, std::ios::binary);
+        if (!in) {
+            error = "could not read " + f;
+            return false;
+        }
+        contents.emplace_back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size_t slash = f.find_last_of("/\\");
+        names.push_back(slash == std::string::npos ? f : f.substr(slash + 1));
+        if (names.back().size() > 0xFFFF) {
+            error = "file name too long: " + f;
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> header;
+    for (char c : { 'S', 'N', 'K', 'P' }) header.push_back(uint8_t(c));
+    putLe(header, ASSET_PACK_VERSION, 4);
+    putLe(header, files.size(), 4);
+    size_t directorySize = 0;
+    for (const std::string& n : names) directorySize += 2 + n.size() + 16;
+
+    uint64_t offset = header.size() + directorySize;
+    for (size_t i = 0; i < names.size(); ++i) {
+        putLe(header, names[i].size(), 2);
+        header.insert(header.end(), names[i].begin(), names[i].end());
+        putLe(header, offset, 8);
+        putLe(header, contents[i].size(), 8);
+        offset += contents[i].size();
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(header.data()), std::streamsize(header.size()));
+    for (const auto& c : contents) {
+        out.write(reinterpret_cast<const char*>(c.data()), std::streamsize(c.size()));
+    }
+    if (!out) {
+        error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Asset pack
+//
+// Every asset in one file that is memory-mapped instead of read, so opening
+// it costs one system call and assets are paged in as they are decoded:
+//
+//   "SNKP"  u32 version  u32 count            (little endian)
+//   count x { u16 nameLength  name  u64 offset  u64 size }
+//   asset bytes, at the offsets above (from the start of the file)
+//
+// No SFML types, so the headless tool can build packs.
+// ─────────────────────────────────────────────────────────────────────────────
+
+const uint32_t ASSET_PACK_VERSION = 1;
+
+// Read-only view of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* data() const { return bytes; }
+    size_t         size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t         length = 0;
+#if defined(_WIN32)
+    void*          mapping = nullptr;   // HANDLE of the file mapping
+#endif
+};
+
+class AssetPack {
+public:
+    // Maps the pack and validates its directory; false if it is missing or malformed
+    bool open(const std::string& path);
+    bool isOpen() const { return file.data() != nullptr; }
+
+    // Bytes of the named asset, valid while the pack is open; nullptr if absent
+    const uint8_t* find(const std::string& name, size_t& size) const;
+
+private:
+    struct Entry {
+        std::string name;
+        uint64_t    offset;
+        uint64_t    size;
+    };
+
+    MappedFile         file;
+    std::vector<Entry> entries;
+};
+
+// Writes `files` into a pack at `path`, each stored under its file name.
+// On failure returns false and describes the problem in `error`.
+bool writeAssetPack(const std::string& path, const std::vector<std::string>& files,
+                    std::string& error);
@@ -0,0 +1,41 @@
+﻿#include "Assets.h"
+
+#include <chrono>
+
+AssetLoader::~AssetLoader() {
+    if (worker.joinable()) worker.join();
+}
+
+void AssetLoader::start(const std::string& packPath) {
+    if (worker.joinable()) return;
+    worker = std::thread(&AssetLoader::run, this, packPath);
+}
+
+void AssetLoader::run(std::string packPath) {
+    auto t0 = std::chrono::steady_clock::now();
+    pack.open(packPath);
+
+    // Pack entry if present, loose file otherwise
+    auto load = [&](const char* name, auto fromMemory, auto fromFile) {
+        size_t size = 0;
+        const uint8_t* data = pack.isOpen() ? pack.find(name, size) : nullptr;
+        bool ok = data ? fromMemory(data, size) : fromFile(name);
+        packUsed = packUsed || (ok && data);
+        if (!ok) messages.push_back(std::string("could not load ") + name);
+        loaded.fetch_add(1, std::memory_order_relaxed);
+        return ok;
+    };
+
+    result.fontLoaded = load(FONT_FILE,
+        [&](const uint8_t* d, size_t n) { return result.font.openFromMemory(d, n); },
+        [&](const char* f) { return result.font.openFromFile(f); });
+    load(EAT_SOUND_FILE,
+        [&](const uint8_t* d, size_t n) { return result.eat.loadFromMemory(d, n); },
+        [&](const char* f) { return result.eat.loadFromFile(f); });
+    load(GAME_OVER_SOUND_FILE,
+        [&](const uint8_t* d, size_t n) { return result.gameOver.loadFromMemory(d, n); },
+        [&](const char* f) { return result.gameOver.loadFromFile(f); });
+
+    workerMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    done.store(true, std::memory_order_release);
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include "AssetPack.h"
+
+#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Asynchronous asset loading
+//
+// The window opens first and shows a progress bar while a worker thread
+// decodes the font and sounds. Each asset comes from the memory-mapped pack
+// when there is one and it holds that asset, otherwise from the loose file
+// next to the executable. Decoding needs no OpenGL context: glyphs are only
+// rendered into textures when text is first drawn, on the main thread.
+// ─────────────────────────────────────────────────────────────────────────────
+
+const char* const ASSET_PACK_FILE = "assets.pak";
+const char* const FONT_FILE = "arial.ttf";
+const char* const EAT_SOUND_FILE = "eat.wav";
+const char* const GAME_OVER_SOUND_FILE = "gameover.wav";
+
+struct GameAssets {
+    sf::Font        font;
+    sf::SoundBuffer eat;
+    sf::SoundBuffer gameOver;
+    bool            fontLoaded = false;
+};
+
+class AssetLoader {
+public:
+    static const int ASSET_COUNT = 3;
+
+    AssetLoader() = default;
+    ~AssetLoader();                     // waits for the worker
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Starts the worker; `packPath` may name a pack that doesn't exist
+    void start(const std::string& packPath);
+
+    bool  ready() const { return done.load(std::memory_order_acquire); }
+    float progress() const { return float(loaded.load(std::memory_order_relaxed)) / ASSET_COUNT; }
+
+    // Only valid once ready(). The pack stays mapped for the loader's
+    // lifetime, because a font opened from memory keeps reading from it.
+    GameAssets&                     assets() { return result; }
+    const std::vector<std::string>& warnings() const { return messages; }
+    bool                            fromPack() const { return packUsed; }
+    double                          loadMs() const { return workerMs; }
+
+private:
+    void run(std::string packPath);
+
+    AssetPack                pack;      // declared before result: outlives the font
+    GameAssets               result;
+    std::vector<std::string> messages;
+    bool                     packUsed = false;
+    double                   workerMs = 0.0;
+
+    std::thread       worker;
+    std::atomic<int>  loaded{ 0 };
+    std::atomic<bool> done{ false };
+};
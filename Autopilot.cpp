@@ -0,0 +1,311 @@
+﻿#include "Autopilot.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+static const Direction ALL_DIRECTIONS[4] = { Up, Down, Left, Right };
+
+Autopilot::Autopilot(Mode mode)
+    : mode_(mode)
+{
+    configure(DEFAULT_COLUMNS, DEFAULT_ROWS);
+}
+
+// Searches only expand interior cells, whose neighbours are always on the
+// board (the border is wall), so neighbours are plain id offsets.
+void Autopilot::configure(int columns, int rows) {
+    cols = columns;
+    rowCount = rows;
+    const size_t cells = size_t(columns) * size_t(rows);
+    neighbourOffsets[0] = -columns;
+    neighbourOffsets[1] = columns;
+    neighbourOffsets[2] = -1;
+    neighbourOffsets[3] = 1;
+
+    cycleDir.assign(cells, None);
+    stamp.assign(cells, 0);
+    gScore.assign(cells, 0);
+    parent.assign(cells, 0);
+    bodyIndex.assign(cells, -1);
+    bodyStamp.assign(cells, 0);
+    generation = 0;
+    bodyGeneration = 0;
+    frontier.reserve(cells * 4);
+    frontierNext.reserve(cells * 4);
+    queue.reserve(cells);
+    path.reserve(cells);
+    occupied.resize(columns, rows);
+    region.resize(columns, rows);
+    buildCycle();
+    forget();
+}
+
+// Interior is (cols-2) x (rowCount-2). With an even number of interior rows:
+// run right along the top row, snake back and forth through the remaining
+// rows in columns 2.., then return up column 1 to the start. With an even
+// number of interior columns instead, the same pattern transposed: down
+// column 1, snake up and down the remaining columns in rows 2.., then back
+// left along the top row. An odd x odd interior has no Hamiltonian cycle
+// (a grid cycle alternates colours, so it needs an even cell count).
+void Autopilot::buildCycle() {
+    const int left = 1, right = cols - 2, top = 1, bottom = rowCount - 2;
+    std::fill(cycleDir.begin(), cycleDir.end(), uint8_t(None));
+    if ((bottom - top + 1) % 2 == 0 && right - left >= 1) {
+        for (int x = left; x < right; ++x) cycleDir[idOf({ x, top })] = Right;
+        cycleDir[idOf({ right, top })] = Down;
+        for (int y = top + 1; y <= bottom; ++y) {
+            bool leftwards = (y - top) % 2 == 1;
+            for (int x = left + 1; x <= right; ++x) {
+                bool rowEnd = leftwards ? x == left + 1 : x == right;
+                if (rowEnd) cycleDir[idOf({ x, y })] = y == bottom ? Left : Down;
+                else        cycleDir[idOf({ x, y })] = leftwards ? Left : Right;
+            }
+        }
+        for (int y = top + 1; y <= bottom; ++y) cycleDir[idOf({ left, y })] = Up;
+        cycleValid = true;
+    }
+    else if ((right - left + 1) % 2 == 0 && bottom - top >= 1) {
+        for (int y = top; y < bottom; ++y) cycleDir[idOf({ left, y })] = Down;
+        cycleDir[idOf({ left, bottom })] = Right;
+        for (int x = left + 1; x <= right; ++x) {
+            bool upwards = (x - left) % 2 == 1;
+            for (int y = top + 1; y <= bottom; ++y) {
+                bool columnEnd = upwards ? y == top + 1 : y == bottom;
+                if (columnEnd) cycleDir[idOf({ x, y })] = x == right ? Up : Right;
+                else           cycleDir[idOf({ x, y })] = upwards ? Up : Down;
+            }
+        }
+        for (int x = left + 1; x <= right; ++x) cycleDir[idOf({ x, top })] = Left;
+        cycleValid = true;
+    }
+    else {
+        cycleValid = false;
+    }
+}
+
+void Autopilot::markBody(const SnakeSim& sim) {
+    if (++bodyGeneration == 0) {
+        std::fill(bodyStamp.begin(), bodyStamp.end(), 0);
+        bodyGeneration = 1;
+    }
+    const SnakeBody& body = sim.body();
+    for (size_t i = 0; i < body.size(); ++i) {
+        uint32_t id = idOf(body[i]);
+        bodyStamp[id] = bodyGeneration;
+        bodyIndex[id] = int(i);
+    }
+}
+
+// A* with Manhattan distance. Body segment i (0 = head) has moved away after
+// len - i moves, so a body cell may be entered if we arrive no earlier.
+// Every step changes g by 1 and h by +-1, so a successor's f is either the
+// current f or f + 2: two stacks replace the priority queue.
+bool Autopilot::findPath(const SnakeSim& sim, const Cell& goal) {
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    const int len = int(sim.body().size());
+    const Cell start = sim.head();
+    const uint32_t neck = len > 1 ? idOf(sim.body()[1]) : UINT32_MAX;
+    const Bitboard& blocked = sim.blockedCells();
+    auto h = [&](const Cell& c) { return std::abs(c.x - goal.x) + std::abs(c.y - goal.y); };
+
+    frontier.clear();
+    frontierNext.clear();
+    uint32_t startId = idOf(start);
+    stamp[startId] = generation;
+    gScore[startId] = 0;
+    parent[startId] = startId;
+    frontier.push_back(startId);
+    int f = h(start);
+
+    for (;;) {
+        if (frontier.empty()) {
+            if (frontierNext.empty()) break;
+            frontier.swap(frontierNext);
+            f += 2;
+        }
+        uint32_t id = frontier.back();
+        frontier.pop_back();
+        Cell c = cellOf(id);
+        int g = gScore[id];
+        if (f > g + h(c)) continue;                 // stale entry
+
+        if (c == goal) {
+            path.clear();
+            for (uint32_t at = id; at != startId; at = parent[at]) path.push_back(cellOf(at));
+            std::reverse(path.begin(), path.end());
+            return true;
+        }
+
+        for (int offset : neighbourOffsets) {
+            uint32_t nid = uint32_t(int(id) + offset);
+            if (blockedId(blocked, nid)) {
+                // Wall, obstacle, or a segment that hasn't moved away yet
+                if (bodyStamp[nid] != bodyGeneration || g + 1 < len - bodyIndex[nid]) continue;
+            }
+            if (id == startId && nid == neck) continue;   // reversal is ignored
+            if (stamp[nid] == generation && gScore[nid] <= g + 1) continue;
+            stamp[nid] = generation;
+            gScore[nid] = g + 1;
+            parent[nid] = id;
+            if (g + 1 + h(cellOf(nid)) == f) frontier.push_back(nid);
+            else                                frontierNext.push_back(nid);
+        }
+    }
+    return false;
+}
+
+// Plays `path` on a copy of the body (growing by one at the end if `grows`)
+// and checks that the new head can still reach the new tail. If it can, the
+// snake can always fall back to following its tail, so the path is safe.
+bool Autopilot::tailReachableAfterPath(const SnakeSim& sim, bool grows) {
+    const SnakeBody& body = sim.body();
+    const size_t newLength = body.size() + (grows ? 1 : 0);
+    if (newLength <= 2 || path.empty()) return true;
+
+    // New body: the last newLength path cells (head last), then as many old
+    // segments from the head as still fit. Vacated segments are cleared
+    // before the path is set, since the path may run over them.
+    occupied = sim.blockedCells();
+    size_t kept = newLength > path.size() ? newLength - path.size() : 0;
+    for (size_t i = kept; i < body.size(); ++i) occupied.reset(body[i]);
+    size_t firstOnBody = path.size() > newLength ? path.size() - newLength : 0;
+    for (size_t i = firstOnBody; i < path.size(); ++i) occupied.set(path[i]);
+
+    // The tail cell counts as reachable even though it is occupied (it
+    // moves out of the way first)
+    Cell tail = kept > 0 ? body[kept - 1] : path[firstOnBody];
+    occupied.reset(tail);
+    Bitboard::floodFill(occupied, path.back(), region);
+    return region.test(tail);
+}
+
+// No safe path to food: of the moves after which the tail is still
+// reachable, take the one furthest (by BFS) from the tail, which stalls for
+// time along the longest route. If none keeps the tail in reach, take the
+// move with the most room.
+Direction Autopilot::followTail(const SnakeSim& sim) {
+    const Cell head = sim.head();
+    const Cell tail = sim.body().back();
+
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    queue.clear();
+    queue.push_back(idOf(tail));
+    stamp[idOf(tail)] = generation;
+    gScore[idOf(tail)] = 0;
+    const Bitboard& blocked = sim.blockedCells();
+    for (size_t i = 0; i < queue.size(); ++i) {
+        for (int offset : neighbourOffsets) {
+            uint32_t nid = uint32_t(int(queue[i]) + offset);
+            if (blockedId(blocked, nid) || stamp[nid] == generation) continue;
+            stamp[nid] = generation;
+            gScore[nid] = gScore[queue[i]] + 1;
+            queue.push_back(nid);
+        }
+    }
+
+    // Candidates first, since the safety check reuses the scratch buffers
+    Direction moves[4];
+    Cell      candidates[4];
+    int       distance[4];
+    int       count = 0;
+    for (Direction d : ALL_DIRECTIONS) {
+        if (d == opposite(sim.heading())) continue;
+        Cell n = advance(head, d);
+        if (sim.blocked(n) && !(n == tail && sim.body().size() > 2)) continue;
+        uint32_t nid = idOf(n);
+        moves[count] = d;
+        candidates[count] = n;
+        distance[count] = stamp[nid] == generation ? gScore[nid] : -1;
+        ++count;
+    }
+
+    Direction best = None;
+    int bestScore = -1;
+    for (int i = 0; i < count; ++i) {
+        Cell n = candidates[i];
+        path.assign(1, n);
+        int score = 0;
+        if (distance[i] >= 0 && tailReachableAfterPath(sim, n == sim.foodCell())) {
+            score = (1 << 20) + distance[i];
+        }
+        else {
+            score = sim.reachableFrom(n);
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best = moves[i];
+        }
+    }
+    return best == None ? sim.heading() : best;
+}
+
+// The tail cell counts as free (it moves out of the way first), except on a
+// two-cell snake, where the tail is also the neck and the move a reversal.
+// That happens when the cycle is switched on mid-game with the snake lying
+// against it; the path logic takes over until the head is back on course.
+Direction Autopilot::followCycle(const SnakeSim& sim) {
+    Direction d = Direction(cycleDir[idOf(sim.head())]);
+    if (d == None || (sim.body().size() > 1 && d == opposite(sim.heading()))) return None;
+    Cell n = advance(sim.head(), d);
+    if (sim.blocked(n) && n != sim.body().back()) return None;
+    return d;
+}
+
+Direction Autopilot::followPath(const SnakeSim& sim) {
+    bool goalStill = pathToBonus ? sim.bonusActive() && sim.bonusCell() == pathGoal
+                                 : sim.foodCell() == pathGoal;
+    if (!pathValid || pathPos >= path.size() || !(sim.head() == pathHead) ||
+        !goalStill || sim.level() != pathLevel || sim.body().size() != pathLength)
+    {
+        pathValid = false;
+        return None;
+    }
+    Cell to = path[pathPos++];
+    pathHead = to;
+    for (Direction d : ALL_DIRECTIONS) {
+        if (advance(sim.head(), d) == to) return d;
+    }
+    pathValid = false;
+    return None;
+}
+
+Direction Autopilot::next(const SnakeSim& sim) {
+    if (sim.columns() != cols || sim.rows() != rowCount) configure(sim.columns(), sim.rows());
+
+    if (mode_ == HamiltonianCycle && cycleValid && sim.obstacleCells().empty()) {
+        pathValid = false;
+        Direction d = followCycle(sim);
+        if (d != None) return d == sim.heading() ? None : d;
+    }
+
+    Direction d = followPath(sim);
+    if (d == None) {
+        markBody(sim);
+        Cell goals[2] = { sim.bonusCell(), sim.foodCell() };
+        // After circling for a whole board's worth of moves the safe path is
+        // not coming; take any path rather than loop forever
+        bool desperate = tailTicks > size_t(cols) * size_t(rowCount);
+        for (int i = sim.bonusActive() ? 0 : 1; i < 2 && !pathValid; ++i) {
+            if (findPath(sim, goals[i]) && !path.empty() &&
+                (desperate || tailReachableAfterPath(sim, i == 1)))
+            {
+                pathValid = true;
+                pathPos = 0;
+                pathHead = sim.head();
+                pathGoal = goals[i];
+                pathToBonus = i == 0;
+                pathLevel = sim.level();
+                pathLength = sim.body().size();
+            }
+        }
+        tailTicks = pathValid ? 0 : tailTicks + 1;
+        d = pathValid ? followPath(sim) : followTail(sim);
+    }
+    return d == sim.heading() ? None : d;
+}
@@ -0,0 +1,105 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Autopilot
+//
+// Plays the game through the same Direction input as the keyboard, one
+// decision per sim tick.
+//
+//   PathToFood        A* to the bonus (while it is up) or the food. The path
+//                     knows when each body segment will have moved away, and
+//                     is only taken if the tail is still reachable after
+//                     eating; otherwise the snake chases its own tail along
+//                     the longest route until a safe path opens up, or
+//                     takes a risk after circling for too long. (It can
+//                     still be boxed in by obstacles moving on a level-up,
+//                     which no plan can foresee.) A safe
+//                     path stays safe while it is followed, so it is kept
+//                     and only re-planned when the goal or the board changes.
+//   HamiltonianCycle  Follows a fixed cycle through every interior cell, so
+//                     the snake can never trap itself and fills the whole
+//                     board eventually. Obstacles break the cycle, so it
+//                     only runs on an obstacle-free board: in the game that
+//                     is level 1 (obstacles come with level 2), and from
+//                     then on it plays exactly like PathToFood. The cycle
+//                     runs along rows when the interior has an even number
+//                     of rows, down columns when it has an even number of
+//                     columns; an odd x odd interior has none, and there
+//                     the mode falls back to PathToFood as well.
+//
+// Scratch buffers are sized for the sim's board on first use (and again if
+// the board size changes), so a decision doesn't touch the heap. One
+// Autopilot must not be shared between threads.
+// ─────────────────────────────────────────────────────────────────────────────
+
+class Autopilot {
+public:
+    enum Mode { PathToFood, HamiltonianCycle };
+
+    explicit Autopilot(Mode mode = PathToFood);
+
+    void setMode(Mode m) { mode_ = m; }
+    Mode mode() const { return mode_; }
+
+    Direction next(const SnakeSim& sim);
+
+    // Drop the cached path (call when the sim is reset or changed outside step())
+    void forget() { pathValid = false; tailTicks = 0; }
+
+private:
+    uint32_t idOf(const Cell& c) const { return uint32_t(c.y) * uint32_t(cols) + uint32_t(c.x); }
+    Cell     cellOf(uint32_t id) const { return { int(id % uint32_t(cols)), int(id / uint32_t(cols)) }; }
+    bool     blockedId(const Bitboard& blocked, uint32_t id) const { return blocked.test(cellOf(id)); }
+
+    void      configure(int columns, int rows);
+    void      markBody(const SnakeSim& sim);
+    bool      findPath(const SnakeSim& sim, const Cell& goal);
+    bool      tailReachableAfterPath(const SnakeSim& sim, bool grows);
+    Direction followTail(const SnakeSim& sim);
+    Direction followCycle(const SnakeSim& sim);
+    Direction followPath(const SnakeSim& sim);
+    void      buildCycle();
+
+    Mode mode_;
+    int  cols = 0;                      // board size the buffers are built for
+    int  rowCount = 0;
+    int  neighbourOffsets[4] = {};      // Up, Down, Left, Right in cell ids
+
+    // Hamiltonian cycle: cycleDir[id] is the move out of interior cell id
+    std::vector<uint8_t> cycleDir;
+    bool                 cycleValid = false;
+
+    // Per-cell scratch. Entries are only valid where stamp[id] == generation,
+    // which avoids clearing the arrays before every search.
+    std::vector<uint32_t> stamp;
+    uint32_t              generation = 0;
+    std::vector<int>      gScore;
+    std::vector<uint32_t> parent;
+    std::vector<int>      bodyIndex;    // segment index from the head, -1 if free
+    std::vector<uint32_t> bodyStamp;
+    uint32_t              bodyGeneration = 0;
+
+    std::vector<uint32_t> frontier;     // A* open cells with f == current f
+    std::vector<uint32_t> frontierNext; // ... and with f + 2
+    std::vector<uint32_t> queue;
+    std::vector<Cell>     path;         // head-exclusive, path[0] is the next cell
+    Bitboard              occupied;     // tailReachableAfterPath() scratch
+    Bitboard              region;
+
+    // The path being followed: path[pathPos] is the next cell. The plan holds
+    // while the head is at pathHead and the goal, level and length are as
+    // planned (eating something on the way shifts every segment's timing).
+    bool   pathValid = false;
+    size_t pathPos = 0;
+    Cell   pathHead;
+    Cell   pathGoal;
+    bool   pathToBonus = false;
+    int    pathLevel = 0;
+    size_t pathLength = 0;
+    size_t tailTicks = 0;               // consecutive moves spent following the tail
+};
@@ -0,0 +1,165 @@
+﻿#include "BatchRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Histogram / BatchStats
+// ─────────────────────────────────────────────────────────────────────────────
+
+void Histogram::add(uint64_t value) {
+    size_t bucket = size_t(value / bucketWidth);
+    if (bucket >= counts.size()) counts.resize(bucket + 1, 0);
+    ++counts[bucket];
+}
+
+void Histogram::merge(const Histogram& other) {
+    if (other.counts.size() > counts.size()) counts.resize(other.counts.size(), 0);
+    for (size_t i = 0; i < other.counts.size(); ++i) counts[i] += other.counts[i];
+}
+
+uint64_t Histogram::total() const {
+    uint64_t n = 0;
+    for (uint64_t c : counts) n += c;
+    return n;
+}
+
+uint64_t Histogram::percentile(double p) const {
+    uint64_t target = uint64_t(p * double(total()));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen > target) return (i + 1) * bucketWidth;
+    }
+    return counts.size() * bucketWidth;
+}
+
+void BatchStats::merge(const BatchStats& other) {
+    games += other.games;
+    ticks += other.ticks;
+    score.merge(other.score);
+    length.merge(other.length);
+    for (int i = 0; i < OUTCOME_COUNT; ++i) outcomes[i] += other.outcomes[i];
+    for (int i = 0; i < 6; ++i) {
+        levelGames[i] += other.levelGames[i];
+        levelScore[i] += other.levelScore[i];
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Work-stealing pool
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+// Remaining game ids [begin, end) owned by one worker. The owner takes from
+// the front, thieves split off the back half. Padded so neighbouring
+// workers' locks don't share a cache line.
+struct alignas(64) WorkRange {
+    std::mutex lock;
+    uint64_t   begin = 0;
+    uint64_t   end = 0;
+};
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+bool takeOwn(WorkRange& r, uint64_t& game) {
+    std::lock_guard<std::mutex> guard(r.lock);
+    if (r.begin == r.end) return false;
+    game = r.begin++;
+    return true;
+}
+
+bool steal(std::vector<std::unique_ptr<WorkRange>>& ranges, size_t self) {
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        WorkRange& victim = *ranges[(self + i) % ranges.size()];
+        uint64_t from, to;
+        {
+            std::lock_guard<std::mutex> guard(victim.lock);
+            uint64_t left = victim.end - victim.begin;
+            if (left == 0) continue;
+            to = victim.end;
+            from = victim.end - (left + 1) / 2;
+            victim.end = from;
+        }
+        std::lock_guard<std::mutex> guard(ranges[self]->lock);
+        ranges[self]->begin = from;
+        ranges[self]->end = to;
+        return true;
+    }
+    return false;
+}
+
+void playGame(const BatchConfig& config, uint64_t game, SnakeSim& sim, BatchStats& stats) {
+    uint64_t seed = splitmix64(config.seed ^ splitmix64(game));
+    int level = 1 + int(game % 5);
+    Rng botRng(seed ^ 0xB07B07B07ull);
+
+    sim.reseed(seed);
+    sim.reset(level);
+    size_t longest = sim.body().size();
+    uint64_t lastScored = 0;
+    while (!sim.gameOver() && sim.tick() - lastScored < config.stallTicks) {
+        if (sim.step(config.bot(sim, botRng)) & (EvAteFood | EvAteBonus)) lastScored = sim.tick();
+        longest = std::max(longest, sim.body().size());
+    }
+
+    ++stats.games;
+    stats.ticks += sim.tick();
+    stats.score.add(uint64_t(sim.score()));
+    stats.length.add(longest);
+    ++stats.outcomes[sim.gameOver() ? int(sim.lastDeath()) : int(OutcomeTimeout)];
+    ++stats.levelGames[level];
+    stats.levelScore[level] += uint64_t(sim.score());
+}
+
+} // namespace
+
+BatchStats runBatch(const BatchConfig& config) {
+    unsigned threads = config.threads ? config.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (uint64_t(threads) > config.games) threads = unsigned(std::max<uint64_t>(config.games, 1));
+
+    std::vector<std::unique_ptr<WorkRange>> ranges;
+    for (unsigned t = 0; t < threads; ++t) {
+        ranges.push_back(std::make_unique<WorkRange>());
+        ranges[t]->begin = config.games * t / threads;
+        ranges[t]->end = config.games * (t + 1) / threads;
+    }
+    std::vector<BatchStats> partial(threads);
+
+    auto worker = [&](size_t self) {
+        SnakeSim   sim(1, config.columns, config.rows);   // allocated once, reset per game
+        BatchStats stats;                   // thread-local until the end
+        for (;;) {
+            uint64_t game;
+            if (takeOwn(*ranges[self], game)) {
+                playGame(config, game, sim, stats);
+            }
+            else if (!steal(ranges, self)) {
+                break;                      // no new work is ever added
+            }
+        }
+        partial[self] = std::move(stats);
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, size_t(t));
+    worker(0);
+    for (auto& th : pool) th.join();
+    auto t1 = std::chrono::steady_clock::now();
+
+    BatchStats total;
+    for (const auto& s : partial) total.merge(s);
+    total.seconds = std::chrono::duration<double>(t1 - t0).count();
+    return total;
+}
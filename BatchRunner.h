@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include "Controllers.h"
+
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Parallel self-play
+//
+// Plays many independent games with a bot controller across a pool of
+// worker threads. Game ids are split into one contiguous range per worker;
+// a worker that runs out steals the back half of another worker's range,
+// so a few unusually long games don't leave the other cores idle.
+//
+// Every game gets its seed from (config seed, game id) and its starting
+// level from the game id, so results don't depend on the thread count or
+// on which worker happened to play which game.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct Histogram {
+    explicit Histogram(uint64_t width = 1) : bucketWidth(width) {}
+
+    void     add(uint64_t value);
+    void     merge(const Histogram& other);
+    uint64_t total() const;
+    // Smallest bucket upper bound that covers fraction `p` of the samples
+    uint64_t percentile(double p) const;
+
+    uint64_t              bucketWidth;
+    std::vector<uint64_t> counts;       // counts[i]: values in [i*w, (i+1)*w)
+};
+
+// DeathCause values plus games stopped for scoring nothing for too long
+enum BatchOutcome { OutcomeTimeout = DeathSelf + 1, OUTCOME_COUNT };
+
+struct BatchStats {
+    uint64_t  games = 0;
+    uint64_t  ticks = 0;
+    Histogram score{ 50 };
+    Histogram length{ 10 };             // longest the snake got during the game
+    uint64_t  outcomes[OUTCOME_COUNT] = {};   // final life lost to, by DeathCause
+    uint64_t  levelGames[6] = {};       // indexed by starting level 1..5
+    uint64_t  levelScore[6] = {};
+    double    seconds = 0.0;
+
+    void merge(const BatchStats& other);
+};
+
+struct BatchConfig {
+    uint64_t   games = 10000;
+    unsigned   threads = 0;             // 0: one per hardware thread
+    uint64_t   seed = 1;
+    uint64_t   stallTicks = 20000;      // bots can circle forever without eating
+    int        columns = DEFAULT_COLUMNS;
+    int        rows = DEFAULT_ROWS;
+    Controller bot = greedyBot;
+};
+
+BatchStats runBatch(const BatchConfig& config);
@@ -0,0 +1,65 @@
+﻿#include "Controllers.h"
+#include "Autopilot.h"
+
+#include <cstdlib>
+
+static const Direction ALL_DIRECTIONS[4] = { Up, Down, Left, Right };
+
+Direction wanderBot(const SnakeSim& sim, Rng& rng) {
+    Direction cur = sim.heading();
+    if (cur != None && rng.below(8) != 0 && !sim.blocked(advance(sim.head(), cur))) {
+        return cur;
+    }
+    uint32_t first = rng.below(4);
+    for (uint32_t i = 0; i < 4; ++i) {
+        Direction d = ALL_DIRECTIONS[(first + i) % 4];
+        if (d == opposite(cur)) continue;
+        if (!sim.blocked(advance(sim.head(), d))) return d;
+    }
+    return cur == None ? Up : cur;
+}
+
+Direction greedyBot(const SnakeSim& sim, Rng& rng) {
+    Direction cur = sim.heading();
+    Cell food = sim.foodCell();
+
+    Direction best = cur == None ? Up : cur;
+    int bestDist = -1;
+    bool bestRoomy = false;
+    const int needed = int(sim.body().size());
+    uint32_t first = rng.below(4);   // random start so ties don't favour one side
+    for (uint32_t i = 0; i < 4; ++i) {
+        Direction d = ALL_DIRECTIONS[(first + i) % 4];
+        if (cur != None && d == opposite(cur)) continue;
+        Cell next = advance(sim.head(), d);
+        if (sim.blocked(next) && next != sim.body().back()) continue;
+
+        // Bitboard flood fill: a few dozen word operations per candidate
+        bool roomy = sim.reachableFrom(next) >= needed;
+        int dist = std::abs(next.x - food.x) + std::abs(next.y - food.y);
+        if (bestDist < 0 || (roomy && !bestRoomy) || (roomy == bestRoomy && dist < bestDist)) {
+            best = d;
+            bestDist = dist;
+            bestRoomy = roomy;
+        }
+    }
+    return best;
+}
+
+Direction astarBot(const SnakeSim& sim, Rng&) {
+    thread_local Autopilot pilot(Autopilot::PathToFood);
+    return pilot.next(sim);
+}
+
+Direction hamiltonBot(const SnakeSim& sim, Rng&) {
+    thread_local Autopilot pilot(Autopilot::HamiltonianCycle);
+    return pilot.next(sim);
+}
+
+Controller findController(const std::string& name) {
+    if (name == "wander")   return wanderBot;
+    if (name == "greedy")   return greedyBot;
+    if (name == "astar")    return astarBot;
+    if (name == "hamilton") return hamiltonBot;
+    return nullptr;
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+
+#include <string>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Bot controllers
+//
+// A controller looks at the sim and returns the input for the next step(),
+// exactly like the keyboard path does. They only read the sim, so one
+// controller function can drive any number of sims on different threads;
+// all per-game state is in the Rng passed in.
+// ─────────────────────────────────────────────────────────────────────────────
+
+typedef Direction (*Controller)(const SnakeSim& sim, Rng& rng);
+
+// Keeps its heading, turns at random now and then, and avoids cells that
+// would kill it when it can. Cheap; used for raw throughput benchmarks.
+Direction wanderBot(const SnakeSim& sim, Rng& rng);
+
+// Takes the safe move that gets closest to the food (Manhattan distance),
+// breaking ties at random. Moves into a region smaller than the snake are
+// only taken when nothing else is left; it still traps itself eventually.
+Direction greedyBot(const SnakeSim& sim, Rng& rng);
+
+// Autopilot (Autopilot.h) in PathToFood / HamiltonianCycle mode, one
+// instance per thread
+Direction astarBot(const SnakeSim& sim, Rng& rng);
+Direction hamiltonBot(const SnakeSim& sim, Rng& rng);
+
+// Looks up a controller by its command-line name ("wander", "greedy",
+// "astar", "hamilton"); returns nullptr for unknown names.
+Controller findController(const std::string& name);
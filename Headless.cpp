@@ -0,0 +1,1092 @@
+﻿// Headless driver for the simulation core (no SFML, no window).
+//
+// Build (Linux):   g++ -std=c++17 -O2 -pthread SnakeSim.cpp Replay.cpp Controllers.cpp Autopilot.cpp BatchRunner.cpp AssetPack.cpp StatsStore.cpp LevelGen.cpp ArenaSim.cpp NetSocket.cpp Netplay.cpp Rewind.cpp VideoExport.cpp Headless.cpp -o snake_headless
+// Build (MSVC):    cl /EHsc /std:c++17 /O2 SnakeSim.cpp Replay.cpp Controllers.cpp Autopilot.cpp BatchRunner.cpp AssetPack.cpp StatsStore.cpp LevelGen.cpp ArenaSim.cpp NetSocket.cpp Netplay.cpp Rewind.cpp VideoExport.cpp Headless.cpp /Fe:snake_headless.exe
+//
+// Usage:
+//   snake_headless bench [ticks] [seed]   run the sim flat out and report ticks/s
+//   snake_headless bench-body [moves]     per-move body cost vs snake length
+//                                         (ring buffer vs vector insert-at-front)
+//   snake_headless bench-path [games] [astar|hamilton] [obstacles 0|1]
+//                                         autopilot planning time per tick by length
+//   snake_headless record <file> [seed] [level]
+//                                         play one bot game and save its replay
+//   snake_headless replay <file> [runs]   re-simulate a replay at full speed and
+//                                         check the final score matches
+//   snake_headless bench-reach [queries]  reachable-area query: bitboard flood fill
+//                                         vs a per-cell BFS over the grid
+//   snake_headless bench-board [ticks] [bot]
+//                                         sim, bot and reachability cost per tick
+//                                         on boards from 40x30 up to 1000x1000
+//   snake_headless bench-fill [ticks]    flood fill compiled for the board's row width
+//                                         vs the run-time-width version, per board size
+//   snake_headless batch [games] [threads] [bot] [seed] [COLSxROWS]
+//                                         self-play on all cores, print histograms
+//   snake_headless batch-scale [games] [bot]
+//                                         the same batch at 1, 2, 4, ... threads
+//   snake_headless pack <out.pak> <files...>
+//                                         build the asset pack the game maps at startup
+//   snake_headless bench-levels [seeds] [COLSxROWS]
+//                                         generate level layouts, check every free cell
+//                                         is reachable, time generation vs a cache hit
+//   snake_headless bench-arena [ticks] [agents] [COLSxROWS]
+//                                         many-snake arena with bots: sim and bot
+//                                         time per tick
+//   snake_headless bench-netplay [ticks] [lagMs] [lossPercent] [tickMs]
+//                                         two bot players in versus over loopback UDP
+//                                         with simulated lag: rollbacks, waits, and
+//                                         whether both ends finish in the same state
+//   snake_headless bench-rewind [games]
+//                                         bot games with random rewinds and level
+//                                         restarts: snapshot cost, and whether their
+//                                         replays re-simulate to the same end
+//   snake_headless bench-video <file.y4m|file.rgba> [frames] [WxH]
+//                                         push synthetic frames through the video
+//                                         writer: main-thread cost vs encode/write
+//   snake_headless bench-stats <file> [games]
+//                                         write games through the stats store, then
+//                                         time reloading it, intact and with a torn tail
+
+#include "SnakeSim.h"
+#include "Replay.h"
+#include "Controllers.h"
+#include "Autopilot.h"
+#include "BatchRunner.h"
+#include "AssetPack.h"
+#include "StatsStore.h"
+#include "LevelGen.h"
+#include "ArenaSim.h"
+#include "Netplay.h"
+#include "Rewind.h"
+#include "VideoExport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int runBench(uint64_t totalTicks, uint64_t seed) {
+    SnakeSim sim(seed);
+    Rng ctrl(seed ^ 0xC0FFEEull);
+    sim.reset(1);
+
+    uint64_t games = 1, food = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < totalTicks; ++i) {
+        unsigned ev = sim.step(wanderBot(sim, ctrl));
+        if (ev & EvAteFood) ++food;
+        if (ev & EvGameOver) {
+            sim.reset(1 + int(games % 5));
+            ++games;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "ticks:      " << totalTicks << "\n"
+              << "games:      " << games << "\n"
+              << "food eaten: " << food << "\n"
+              << "time:       " << secs << " s\n"
+              << "throughput: " << (secs > 0 ? totalTicks / secs : 0) << " ticks/s\n"
+              << "per tick:   " << (totalTicks ? secs * 1e9 / totalTicks : 0) << " ns\n";
+    return EXIT_SUCCESS;
+}
+
+// One move of the body at a fixed length: push a new head, drop the tail.
+// The old std::vector layout paid an O(n) memmove for the insert at front;
+// SnakeBody should stay flat all the way up to a board-filling snake.
+static int runBodyBench(uint64_t moves) {
+    const size_t capacity = size_t(DEFAULT_COLUMNS) * DEFAULT_ROWS;
+    const size_t lengths[] = { 1, 16, 64, 256, 512, 1024, capacity - 1 };
+
+    std::cout << "length   ring ns/move   vector ns/move\n";
+    for (size_t len : lengths) {
+        SnakeBody ring(capacity);
+        std::vector<Cell> vec;
+        vec.reserve(capacity);
+        for (size_t i = 0; i < len; ++i) {
+            Cell c{ int(i % DEFAULT_COLUMNS), int(i / DEFAULT_COLUMNS) };
+            ring.pushFront(c);
+            vec.push_back(c);
+        }
+
+        long long sink = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < moves; ++i) {
+            Cell c{ int(i % DEFAULT_COLUMNS), int(i % DEFAULT_ROWS) };
+            ring.pushFront(c);
+            ring.popBack();
+            sink += ring.back().x;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < moves; ++i) {
+            Cell c{ int(i % DEFAULT_COLUMNS), int(i % DEFAULT_ROWS) };
+            vec.insert(vec.begin(), c);
+            vec.pop_back();
+            sink += vec.back().x;
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double ringNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(moves);
+        double vecNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / double(moves);
+        std::cout.width(6);
+        std::cout << len << "   ";
+        std::cout.width(12);
+        std::cout << ringNs << "   ";
+        std::cout.width(14);
+        std::cout << vecNs << (sink == 42 ? " " : "") << "\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+// Per-cell reference for reachableFrom(): breadth-first search over blocked()
+static int reachableBfs(const SnakeSim& sim, Cell from, std::vector<uint8_t>& seen,
+                        std::vector<Cell>& queue) {
+    static const Direction dirs[4] = { Up, Down, Left, Right };
+    std::fill(seen.begin(), seen.end(), 0);
+    queue.clear();
+    queue.push_back(from);
+    const size_t cols = size_t(sim.columns());
+    seen[size_t(from.y) * cols + size_t(from.x)] = 1;
+    int count = 0;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        for (Direction d : dirs) {
+            Cell n = advance(queue[i], d);
+            if (sim.blocked(n)) continue;
+            uint8_t& s = seen[size_t(n.y) * cols + size_t(n.x)];
+            if (s) continue;
+            s = 1;
+            ++count;
+            queue.push_back(n);
+        }
+    }
+    return count;
+}
+
+// Snapshots of bot games at various lengths; every query asks how much of
+// the board is reachable from the head, both ways, and checks they agree.
+static int runReachBench(uint64_t queries) {
+    std::vector<SnakeSim> states;
+    Rng ctrl(99);
+    for (uint64_t seed = 1; states.size() < 64; ++seed) {
+        SnakeSim sim(seed);
+        sim.reseed(seed);
+        sim.reset(1 + int(seed % 5));
+        uint64_t stop = 200 + ctrl.below(4000);
+        while (!sim.gameOver() && sim.tick() < stop) sim.step(greedyBot(sim, ctrl));
+        if (!sim.gameOver()) states.push_back(sim);
+    }
+
+    std::vector<uint8_t> seen(size_t(DEFAULT_COLUMNS) * DEFAULT_ROWS);
+    std::vector<Cell> queue;
+    queue.reserve(size_t(DEFAULT_COLUMNS) * DEFAULT_ROWS);
+    long long sumBits = 0, sumBfs = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < queries; ++i) {
+        const SnakeSim& s = states[i % states.size()];
+        sumBits += s.reachableFrom(s.head());
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < queries; ++i) {
+        const SnakeSim& s = states[i % states.size()];
+        sumBfs += reachableBfs(s, s.head(), seen, queue);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double bitsNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(queries);
+    double bfsNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / double(queries);
+    std::cout << "queries:    " << queries << " over " << states.size() << " positions\n"
+              << "bitboard:   " << bitsNs << " ns/query\n"
+              << "cell BFS:   " << bfsNs << " ns/query\n"
+              << "results:    " << (sumBits == sumBfs ? "agree" : "DIFFER") << "\n";
+    return sumBits == sumBfs ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Autopilot games timed decision by decision. The planner has to stay far
+// below moveDelay; the interesting numbers are the worst case and how it
+// grows with the length of the snake.
+static int runPathBench(int games, Autopilot::Mode mode, bool obstacles) {
+    const size_t bucketWidth = 100;
+    const size_t buckets = size_t(DEFAULT_COLUMNS) * DEFAULT_ROWS / bucketWidth + 1;
+    std::vector<uint64_t> count(buckets, 0), sumNs(buckets, 0), maxNs(buckets, 0);
+    Histogram all(1000);                     // 1 us buckets
+    Autopilot pilot(mode);
+    SnakeSim sim;
+    sim.setObstaclesEnabled(obstacles);
+    size_t longest = 0;
+    long long totalScore = 0;
+    uint64_t reversals = 0;
+
+    for (int g = 0; g < games; ++g) {
+        sim.reseed(uint64_t(g) + 1);
+        sim.reset(1 + g % 5);
+        // The cycle is switched on after the first food, as T does in the
+        // game, so it has to pick the snake up wherever it lies
+        pilot.setMode(Autopilot::PathToFood);
+        pilot.forget();
+        uint64_t lastScored = 0;
+        while (!sim.gameOver() && sim.tick() - lastScored < 20000) {
+            size_t len = sim.body().size();
+            if (len > 1 && pilot.mode() != mode) {
+                pilot.setMode(mode);
+                pilot.forget();
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            Direction d = pilot.next(sim);
+            auto t1 = std::chrono::steady_clock::now();
+            if (len > 1 && d == opposite(sim.heading())) ++reversals;
+            uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+            size_t b = len / bucketWidth;
+            ++count[b];
+            sumNs[b] += ns;
+            maxNs[b] = std::max(maxNs[b], ns);
+            all.add(ns);
+
+            if (sim.step(d) & (EvAteFood | EvAteBonus)) lastScored = sim.tick();
+            longest = std::max(longest, sim.body().size());
+        }
+        totalScore += sim.score();
+    }
+
+    std::cout << "games:        " << games << " (mean score " << totalScore / std::max(games, 1)
+              << ", longest snake " << longest << " of "
+              << (DEFAULT_COLUMNS - 2) * (DEFAULT_ROWS - 2) << " cells)\n\n"
+              << "length      ticks     avg us     max us\n";
+    uint64_t worst = 0;
+    for (size_t b = 0; b < buckets; ++b) {
+        if (count[b] == 0) continue;
+        worst = std::max(worst, maxNs[b]);
+        std::cout.width(6);
+        std::cout << b * bucketWidth << "+ ";
+        std::cout.width(10);
+        std::cout << count[b] << " ";
+        std::cout.width(10);
+        std::cout << double(sumNs[b]) / count[b] / 1000.0 << " ";
+        std::cout.width(10);
+        std::cout << double(maxNs[b]) / 1000.0 << "\n";
+    }
+
+    // The max includes any time the OS took the core away mid-plan
+    uint64_t p999 = all.percentile(0.999);
+    std::cout << "\np50 < " << all.percentile(0.5) / 1000 << " us, p99 < "
+              << all.percentile(0.99) / 1000 << " us, p99.9 < " << p999 / 1000
+              << " us, max " << worst / 1000.0 << " us\n";
+    for (int level : { 5, 10 }) {
+        double delayNs = INITIAL_MOVE_DELAY * std::pow(0.9, level - 1) * 1e9;
+        std::cout << "moveDelay at level " << level << ": " << delayNs / 1e6 << " ms ("
+                  << (p999 ? delayNs / double(p999) : 0) << "x the p99.9 plan)\n";
+    }
+    // step() ignores a reversal, so one means the bot's plan was not what played
+    std::cout << "reversals:    " << reversals << (reversals ? " (the bot turned back on itself)" : "") << "\n";
+    return reversals == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// One bot game per board size, growing to a million cells. Sim and bot time
+// are measured separately, with a reachability query from the head every
+// tick, so it shows which part stops scaling with the board.
+static int runBoardBench(uint64_t ticks, Controller bot) {
+    const int sizes[][2] = { { 40, 30 }, { 64, 64 }, { 128, 128 }, { 256, 256 },
+                             { 512, 512 }, { 1000, 1000 } };
+    using clock = std::chrono::steady_clock;
+    auto ns = [](clock::time_point a, clock::time_point b) {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+    };
+
+    std::cout << "board        reset us    step ns     bot us   reach us   longest\n";
+    for (const auto& size : sizes) {
+        SnakeSim sim(1, size[0], size[1]);
+        Rng ctrl(7);
+        auto r0 = clock::now();
+        sim.reset(1);
+        auto r1 = clock::now();
+
+        double stepNs = 0, botNs = 0, reachNs = 0;
+        size_t longest = 0;
+        long long sink = 0;
+        for (uint64_t i = 0; i < ticks; ++i) {
+            auto t0 = clock::now();
+            Direction d = bot(sim, ctrl);
+            auto t1 = clock::now();
+            unsigned ev = sim.step(d);
+            auto t2 = clock::now();
+            sink += sim.reachableFrom(sim.head());
+            auto t3 = clock::now();
+            botNs += ns(t0, t1);
+            stepNs += ns(t1, t2);
+            reachNs += ns(t2, t3);
+            longest = std::max(longest, sim.body().size());
+            if (ev & EvGameOver) {
+                sim.reseed(i + 2);
+                sim.reset(1);
+            }
+        }
+
+        std::string name = std::to_string(size[0]) + "x" + std::to_string(size[1]);
+        std::cout << name << std::string(name.size() < 10 ? 10 - name.size() : 0, ' ');
+        std::cout.width(10);
+        std::cout << ns(r0, r1) / 1000.0 << " ";
+        std::cout.width(10);
+        std::cout << stepNs / double(ticks) << " ";
+        std::cout.width(10);
+        std::cout << botNs / double(ticks) / 1000.0 << " ";
+        std::cout.width(10);
+        std::cout << reachNs / double(ticks) / 1000.0 << " ";
+        std::cout.width(9);
+        std::cout << longest << (sink == 42 ? " " : "") << "\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+// A greedy-bot game per board size, flood filling from the head every tick
+// with the specialised fill and with the generic one (alternating which goes
+// first). Both must give the same region. "Tick" is step() plus one fill,
+// what a bot that checks reachability costs per tick.
+static int runFillBench(uint64_t ticks) {
+    const int sizes[][2] = { { 40, 30 }, { 100, 80 }, { 200, 150 }, { 300, 200 },
+                             { 512, 512 }, { 700, 500 }, { 1000, 1000 } };
+    using clock = std::chrono::steady_clock;
+    auto ns = [](clock::time_point a, clock::time_point b) {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+    };
+
+    bool same = true;
+    std::cout << "board      words   step ns  fill ns  generic ns  speedup  ticks/s  generic ticks/s\n";
+    for (const auto& size : sizes) {
+        SnakeSim sim(1, size[0], size[1]);
+        Rng ctrl(7);
+        Bitboard special, generic;
+        double stepNs = 0, specialNs = 0, genericNs = 0;
+        for (uint64_t i = 0; i < ticks; ++i) {
+            const Direction d = greedyBot(sim, ctrl);
+            auto t0 = clock::now();
+            unsigned ev = sim.step(d);
+            auto t1 = clock::now();
+            stepNs += ns(t0, t1);
+            if (ev & EvGameOver) {
+                sim.reseed(i + 2);
+                sim.reset(1);
+            }
+            for (int pass = 0; pass < 2; ++pass) {
+                const bool specialFirst = (i & 1) == 0;
+                auto f0 = clock::now();
+                if ((pass == 0) == specialFirst) Bitboard::floodFill(sim.blockedCells(), sim.head(), special);
+                else Bitboard::floodFillGeneric(sim.blockedCells(), sim.head(), generic);
+                auto f1 = clock::now();
+                ((pass == 0) == specialFirst ? specialNs : genericNs) += ns(f0, f1);
+            }
+            same = same && special == generic;
+        }
+
+        const double n = double(ticks);
+        std::string name = std::to_string(size[0]) + "x" + std::to_string(size[1]);
+        std::printf("%-10s %5zu %9.0f %8.0f %11.0f %7.2fx %8.0f %16.0f\n", name.c_str(),
+                    sim.blockedCells().stride(), stepNs / n, specialNs / n, genericNs / n,
+                    genericNs / std::max(specialNs, 1.0), 1e9 * n / (stepNs + specialNs),
+                    1e9 * n / (stepNs + genericNs));
+    }
+    std::cout << "regions: " << (same ? "identical" : "DIFFERENT") << "\n";
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int runRecord(const std::string& path, uint64_t seed, int level) {
+    SnakeSim sim(seed);
+    Rng ctrl(seed ^ 0xC0FFEEull);
+    ReplayWriter writer;
+
+    sim.reseed(seed);
+    sim.reset(level);
+    writer.begin(seed, level, sim.columns(), sim.rows());
+    // Cap the length in case the bot finds a loop it can survive forever
+    while (!sim.gameOver() && sim.tick() < 10000000) {
+        // Only real turns go into the replay, like the game's input queue
+        Direction d = wanderBot(sim, ctrl);
+        if (d == sim.heading()) d = None;
+        writer.record(d);
+        sim.step(d);
+    }
+    writer.finish(sim.score());
+
+    if (!writer.save(path)) {
+        std::cerr << "Error: could not write " << path << "\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "recorded " << sim.tick() << " ticks, score " << sim.score()
+              << ", " << writer.data().size() << " bytes -> " << path << "\n";
+    return EXIT_SUCCESS;
+}
+
+static int runReplay(const std::string& path, int runs) {
+    ReplayReader replay;
+    if (!replay.load(path)) {
+        std::cerr << "Error: " << path << " is not a valid replay\n";
+        return EXIT_FAILURE;
+    }
+
+    SnakeSim sim(replay.seed(), replay.columns(), replay.rows());
+    RewindBuffer history;
+    int score = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; ++r) {
+        sim.reseed(replay.seed());
+        sim.reset(replay.startingLevel());
+        history.begin(sim);
+        replay.rewind();
+        for (uint64_t to;;) {
+            while (replay.restorePending(to)) history.restore(sim, to);
+            if (replay.finished()) break;
+            history.afterStep(sim, sim.step(replay.next()));
+        }
+        score = sim.score();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    double ticks = double(replay.totalTicks()) * runs;
+    bool match = score == replay.finalScore();
+    std::cout << "seed:       " << replay.seed() << "  level " << replay.startingLevel()
+              << "  board " << replay.columns() << "x" << replay.rows() << "\n"
+              << "ticks:      " << replay.totalTicks() << " x " << runs << " runs\n"
+              << "score:      " << score << " (recorded " << replay.finalScore() << ") "
+              << (match ? "MATCH" : "MISMATCH") << "\n"
+              << "throughput: " << (secs > 0 ? ticks / secs : 0) << " ticks/s\n";
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void printHistogram(const char* title, const Histogram& h) {
+    uint64_t peak = 0;
+    for (uint64_t c : h.counts) peak = std::max(peak, c);
+    std::cout << title << " (p50 < " << h.percentile(0.5) << ", p90 < " << h.percentile(0.9)
+              << ", p99 < " << h.percentile(0.99) << ")\n";
+    for (size_t i = 0; i < h.counts.size(); ++i) {
+        if (h.counts[i] == 0) continue;
+        std::cout.width(6);
+        std::cout << i * h.bucketWidth << " ";
+        std::cout.width(8);
+        std::cout << h.counts[i] << " " << std::string(size_t(h.counts[i] * 50 / peak), '#') << "\n";
+    }
+}
+
+static int runBatchCommand(const BatchConfig& config) {
+    BatchStats s = runBatch(config);
+
+    static const char* outcomeNames[OUTCOME_COUNT] = { "none", "wall", "obstacle", "self", "stalled" };
+    std::cout << "games:      " << s.games << " (" << s.ticks << " ticks)\n"
+              << "time:       " << s.seconds << " s\n"
+              << "throughput: " << (s.seconds > 0 ? s.games / s.seconds : 0) << " games/s, "
+              << (s.seconds > 0 ? s.ticks / s.seconds : 0) << " ticks/s\n\n";
+    std::cout << "mean score by starting level:\n";
+    for (int lvl = 1; lvl <= 5; ++lvl) {
+        double mean = s.levelGames[lvl] ? double(s.levelScore[lvl]) / s.levelGames[lvl] : 0.0;
+        std::cout << "  level " << lvl << ": " << mean << " (" << s.levelGames[lvl] << " games)\n";
+    }
+    std::cout << "\nfinal death:\n";
+    for (int i = DeathWall; i < OUTCOME_COUNT; ++i) {
+        std::cout << "  " << outcomeNames[i] << ": " << s.outcomes[i] << "\n";
+    }
+    std::cout << "\n";
+    printHistogram("score", s.score);
+    std::cout << "\n";
+    printHistogram("max length", s.length);
+    return EXIT_SUCCESS;
+}
+
+// Same batch at doubling thread counts; results are identical at every
+// count, only the time should change.
+static int runBatchScale(BatchConfig config) {
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double base = 0.0;
+    std::cout << "threads   games/s   speedup\n";
+    for (unsigned t = 1; ; t = std::min(t * 2, maxThreads)) {
+        config.threads = t;
+        BatchStats s = runBatch(config);
+        double rate = s.seconds > 0 ? s.games / s.seconds : 0;
+        if (t == 1) base = rate;
+        std::cout.width(7);
+        std::cout << t << "   ";
+        std::cout.width(7);
+        std::cout << uint64_t(rate) << "   " << (base > 0 ? rate / base : 0) << "x\n";
+        if (t == maxThreads) break;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Builds a pack and reads every entry back through the mapped view
+static int runPack(const std::string& path, const std::vector<std::string>& files) {
+    std::string error;
+    if (!writeAssetPack(path, files, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return EXIT_FAILURE;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    AssetPack pack;
+    bool ok = pack.open(path);
+    auto t1 = std::chrono::steady_clock::now();
+    size_t total = 0;
+    for (const std::string& f : files) {
+        size_t slash = f.find_last_of("/\\");
+        size_t size = 0;
+        ok = ok && pack.find(slash == std::string::npos ? f : f.substr(slash + 1), size) != nullptr;
+        total += size;
+    }
+    if (!ok) {
+        std::cerr << "Error: " << path << " did not read back\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "packed " << files.size() << " files, " << total << " bytes -> " << path
+              << " (mapped in " << std::chrono::duration<double, std::micro>(t1 - t0).count()
+              << " us)\n";
+    return EXIT_SUCCESS;
+}
+
+// Every level of every seed: the free cells of the layout must form one
+// region, and every obstacle must keep a free side (so leaving any of them
+// out can't open a sealed pocket). Then the same layouts are taken from a
+// cache that built them in the background, as a level-up does.
+static int runLevelBench(int seeds, int columns, int rows) {
+    using clock = std::chrono::steady_clock;
+    int maxLevel = 2;
+    while (obstacleCount(columns, rows, maxLevel + 1) > obstacleCount(columns, rows, maxLevel)) ++maxLevel;
+
+    Bitboard blocked(columns, rows);
+    Bitboard reached;
+    double generateUs = 0.0;
+    size_t placed = 0, wanted = 0;
+    int layouts = 0, failures = 0;
+    for (int s = 0; s < seeds; ++s) {
+        for (int level = 2; level <= maxLevel; ++level) {
+            const LayoutKey key{ columns, rows, level, uint64_t(s) * 0x9E3779B97F4A7C15ull };
+            auto t0 = clock::now();
+            LevelLayout layout = generateLayout(key);
+            generateUs += std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+            placed += layout.obstacles.size();
+            wanted += size_t(obstacleCount(columns, rows, level));
+            ++layouts;
+
+            blocked.clear();
+            for (int x = 0; x < columns; ++x) { blocked.set({ x, 0 }); blocked.set({ x, rows - 1 }); }
+            for (int y = 0; y < rows; ++y) { blocked.set({ 0, y }); blocked.set({ columns - 1, y }); }
+            for (const Cell& c : layout.obstacles) blocked.set(c);
+            Bitboard::floodFill(blocked, { columns / 2, rows / 2 }, reached);
+            bool ok = reached.count() == columns * rows - blocked.count();
+            for (const Cell& c : layout.obstacles) {
+                bool side = false;
+                for (Direction d : { Up, Down, Left, Right }) side = side || !blocked.test(advance(c, d));
+                ok = ok && side;
+            }
+            failures += ok ? 0 : 1;
+        }
+    }
+
+    // Prefetch one level ahead while "playing" the current one
+    LayoutCache cache;
+    double hitUs = 0.0;
+    for (int s = 0; s < seeds; ++s) {
+        const uint64_t seed = uint64_t(s) * 0x9E3779B97F4A7C15ull;
+        cache.prefetch({ columns, rows, 2, seed });
+        for (int level = 2; level <= maxLevel; ++level) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            auto t0 = clock::now();
+            auto layout = cache.get({ columns, rows, level, seed });
+            hitUs += std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+            cache.prefetch({ columns, rows, level + 1, seed });
+        }
+    }
+
+    std::cout << "board:      " << columns << "x" << rows << ", levels 2-" << maxLevel << ", "
+              << layouts << " layouts\n"
+              << "obstacles:  " << placed << " of " << wanted << " placed\n"
+              << "generate:   " << generateUs / layouts << " us/layout\n"
+              << "cached:     " << hitUs / layouts << " us/level-up (" << cache.hits() << " hits, "
+              << cache.misses() << " misses)\n"
+              << "connected:  " << (failures == 0 ? "all" : std::to_string(failures) + " FAILED") << "\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// An arena of bots: every tick, every live agent asks arenaBot() for its
+// move and the arena resolves them all at once
+static int runArenaBench(uint64_t ticks, int agents, int columns, int rows) {
+    using clock = std::chrono::steady_clock;
+    ArenaConfig config;
+    config.columns = columns;
+    config.rows = rows;
+    config.agents = agents;
+    config.food = std::max(agents, 4);
+
+    ArenaSim arena(1);
+    auto r0 = clock::now();
+    arena.reset(config);
+    auto r1 = clock::now();
+
+    Rng ctrl(7);
+    std::vector<Direction> inputs(size_t(arena.agentCount()), None);
+    double botUs = 0.0, stepUs = 0.0, worstStepUs = 0.0;
+    uint64_t eaten = 0;
+    for (uint64_t t = 0; t < ticks; ++t) {
+        auto t0 = clock::now();
+        for (int i = 0; i < arena.agentCount(); ++i) {
+            inputs[size_t(i)] = arena.alive(i) ? arenaBot(arena, i, ctrl) : None;
+        }
+        auto t1 = clock::now();
+        arena.step(inputs);
+        auto t2 = clock::now();
+        botUs += std::chrono::duration<double, std::micro>(t1 - t0).count();
+        const double us = std::chrono::duration<double, std::micro>(t2 - t1).count();
+        stepUs += us;
+        worstStepUs = std::max(worstStepUs, us);
+        for (int i = 0; i < arena.agentCount(); ++i) eaten += (arena.events(i) & ArenaEvAte) ? 1 : 0;
+    }
+
+    uint64_t deaths = 0, kills = 0;
+    uint32_t longest = 0;
+    for (int i = 0; i < arena.agentCount(); ++i) {
+        deaths += arena.deaths(i);
+        kills += arena.kills(i);
+        longest = std::max(longest, arena.length(i));
+    }
+    std::cout << "arena:      " << arena.columns() << "x" << arena.rows() << ", "
+              << arena.agentCount() << " agents, " << ticks << " ticks\n"
+              << "reset:      " << std::chrono::duration<double, std::micro>(r1 - r0).count() << " us\n"
+              << "step:       " << stepUs / double(ticks) << " us/tick (worst " << worstStepUs << ")\n"
+              << "bots:       " << botUs / double(ticks) << " us/tick\n"
+              << "food eaten: " << eaten << ", deaths " << deaths << " (" << kills
+              << " into another snake), longest alive " << longest << "\n";
+    return EXIT_SUCCESS;
+}
+
+// Host and joiner in one process, talking over loopback with `lagMs` of
+// delay each way (so twice that round trip). Both tick on the same clock
+// but start apart by the handshake, as two machines would.
+static int runNetplayBench(int64_t ticks, int lagMs, int lossPercent, int tickMs) {
+    using clock = std::chrono::steady_clock;
+    ArenaConfig config;
+    config.food = 4;
+
+    VersusSession sides[2];
+    NetAddress hostAddress;
+    if (!sides[0].host(0, config, 12345) ||
+        !resolveAddress("127.0.0.1:" + std::to_string(sides[0].localPort()), hostAddress) ||
+        !sides[1].join(hostAddress))
+    {
+        std::cerr << "Error: could not open loopback sockets\n";
+        return EXIT_FAILURE;
+    }
+    for (VersusSession& s : sides) s.setLag(lagMs, lagMs / 5, lossPercent);
+
+    Rng bots[2] = { Rng(1), Rng(2) };
+    double tickUs[2] = { 0.0, 0.0 };
+    double worstUs[2] = { 0.0, 0.0 };
+    const auto start = clock::now();
+    auto nextTick = start;
+    const auto deadline = start + std::chrono::milliseconds(tickMs * ticks * 4 + 5000);
+    while (clock::now() < deadline) {
+        for (VersusSession& s : sides) s.poll();
+        if (sides[0].frame() >= ticks && sides[1].frame() >= ticks &&
+            sides[0].confirmedFrame() >= ticks && sides[1].confirmedFrame() >= ticks)
+        {
+            break;
+        }
+        if (clock::now() >= nextTick) {
+            nextTick += std::chrono::milliseconds(tickMs);
+            for (int i = 0; i < 2; ++i) {
+                VersusSession& s = sides[i];
+                if (s.status() != NetRunning || s.frame() >= ticks) continue;
+                // Turns only, as the keyboard gives them: keeping the heading is None
+                const int me = s.localAgent();
+                Direction turn = s.sim().alive(me) ? arenaBot(s.sim(), me, bots[i]) : None;
+                if (turn == s.plannedHeading()) turn = None;
+                auto t0 = clock::now();
+                s.advance(turn);
+                const double us = std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+                tickUs[i] += us;
+                worstUs[i] = std::max(worstUs[i], us);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    const char* names[2] = { "host", "join" };
+    for (int i = 0; i < 2; ++i) {
+        const VersusSession& s = sides[i];
+        std::printf("%s: %lld ticks (%lld confirmed), %llu rollbacks resimulating %llu ticks "
+                    "(deepest %d), %llu waits, %llu time-sync skips, %.1f us/tick (worst %.0f)\n",
+                    names[i], (long long)s.frame(), (long long)s.confirmedFrame(),
+                    (unsigned long long)s.rollbacks(), (unsigned long long)s.resimulatedTicks(),
+                    s.deepestRollback(), (unsigned long long)s.waits(),
+                    (unsigned long long)s.timeSyncSkips(),
+                    tickUs[i] / double(std::max<int64_t>(s.frame(), 1)), worstUs[i]);
+    }
+    const bool finished = sides[0].frame() == ticks && sides[1].frame() == ticks &&
+                          sides[0].confirmedFrame() == ticks && sides[1].confirmedFrame() == ticks;
+    const bool same = finished && sides[0].sim().checksum() == sides[1].sim().checksum();
+    std::printf("%.1f s for %lld ticks at %d ms with %d ms lag each way, %d%% loss: %s\n",
+                seconds, (long long)ticks, tickMs, lagMs, lossPercent,
+                !finished ? "did not finish" : sides[0].desynced() || sides[1].desynced() || !same
+                                             ? "DESYNC" : "both ends agree");
+    return same && !sides[0].desynced() && !sides[1].desynced() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static bool sameSnapshot(const SimSnapshot& a, const SimSnapshot& b) {
+    return a.columns == b.columns && a.rows == b.rows && a.rngState == b.rngState &&
+           a.ticks == b.ticks && a.layoutSeed == b.layoutSeed && a.tail == b.tail &&
+           a.length == b.length && a.links == b.links && a.obstacleIds == b.obstacleIds &&
+           a.prevTail == b.prevTail && a.food == b.food && a.bonus == b.bonus &&
+           a.dir == b.dir && a.death == b.death && a.foodPlaced == b.foodPlaced &&
+           a.bonusOn == b.bonusOn && a.over == b.over &&
+           a.bonusSpawnElapsed == b.bonusSpawnElapsed && a.bonusLiveElapsed == b.bonusLiveElapsed &&
+           a.moveDelay == b.moveDelay && a.score == b.score && a.level == b.level &&
+           a.lives == b.lives && a.nextLevelScore == b.nextLevelScore;
+}
+
+// Greedy-bot games that every so often go back a random number of ticks or
+// to the start of the level, recorded as the game records them. Each replay
+// must re-simulate to the same final state, and every snapshot taken must
+// restore into a fresh sim and save back unchanged.
+static int runRewindBench(int games) {
+    using clock = std::chrono::steady_clock;
+    double saveNs = 0.0, restoreNs = 0.0;
+    uint64_t saves = 0, restores = 0, levelRestarts = 0, ticks = 0;
+    size_t longest = 0;
+    int failures = 0;
+
+    for (int g = 0; g < games; ++g) {
+        const uint64_t seed = 1000 + uint64_t(g);
+        SnakeSim sim(seed);
+        RewindBuffer history;
+        ReplayWriter writer;
+        Rng ctrl(seed ^ 0xC0FFEEull);
+        Rng chaos(seed);
+
+        sim.reset(1);
+        history.begin(sim);
+        writer.begin(seed, 1, sim.columns(), sim.rows());
+        int restoresLeft = 40;
+        while (!sim.gameOver() && sim.tick() < 200000) {
+            Direction d = greedyBot(sim, ctrl);
+            if (d == sim.heading()) d = None;
+            writer.record(d);
+            const unsigned ev = sim.step(d);
+            auto t0 = clock::now();
+            history.afterStep(sim, ev);
+            saveNs += std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            ++saves;
+            if (ev & EvGameOver || restoresLeft == 0 || chaos.below(200) != 0) continue;
+
+            const bool restart = chaos.below(4) == 0;
+            t0 = clock::now();
+            const bool went = restart ? history.restartLevel(sim)
+                                      : history.rewind(sim, 1 + chaos.below(RewindBuffer::DEFAULT_TICKS));
+            restoreNs += std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            if (!went) continue;
+            writer.recordRestore(sim.tick());
+            --restoresLeft;
+            ++restores;
+            levelRestarts += restart ? 1 : 0;
+        }
+        writer.finish(sim.score());
+        ticks += sim.tick();
+        longest = std::max(longest, sim.body().size());
+
+        SimSnapshot expected, roundTrip;
+        sim.save(expected);
+        SnakeSim fresh(1);
+        fresh.restore(expected);
+        fresh.save(roundTrip);
+
+        ReplayReader replay;
+        SnakeSim again(seed);
+        RewindBuffer againHistory;
+        bool replayed = replay.parse(writer.data());
+        if (replayed) {
+            again.reset(replay.startingLevel());
+            againHistory.begin(again);
+            for (uint64_t to;;) {
+                while (replay.restorePending(to)) replayed = againHistory.restore(again, to) && replayed;
+                if (replay.finished()) break;
+                againHistory.afterStep(again, again.step(replay.next()));
+            }
+        }
+        SimSnapshot final;
+        again.save(final);
+        if (!sameSnapshot(expected, roundTrip) || !replayed || !sameSnapshot(expected, final)) {
+            std::cerr << "game " << g << " (seed " << seed << "): "
+                      << (!sameSnapshot(expected, roundTrip) ? "snapshot round trip differs"
+                                                             : "replay does not re-simulate to the same end")
+                      << "\n";
+            ++failures;
+        }
+    }
+
+    std::printf("%d games, %llu ticks, %llu restores (%llu level restarts), longest snake %zu\n",
+                games, (unsigned long long)ticks, (unsigned long long)restores,
+                (unsigned long long)levelRestarts, longest);
+    std::printf("snapshot:   %.0f ns per tick\n", saveNs / double(std::max<uint64_t>(saves, 1)));
+    std::printf("restore:    %.0f ns\n", restoreNs / double(std::max<uint64_t>(restores, 1)));
+    std::printf("replays:    %s\n", failures == 0 ? "all MATCH" : "MISMATCH");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Frames of a bar sweeping across a gradient, pushed the way the offline
+// export pushes them (waiting for a free slot). The main thread's share is
+// the copy into the ring; the rest is the writer's.
+static int runVideoBench(const std::string& path, int frames, unsigned width, unsigned height) {
+    using clock = std::chrono::steady_clock;
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    VideoWriter video;
+    if (!video.start(path, width, height, 30)) {
+        std::cerr << "Error: could not write " << path << "\n";
+        return EXIT_FAILURE;
+    }
+
+    double pushUs = 0.0, worstPushUs = 0.0;
+    auto t0 = clock::now();
+    for (int f = 0; f < frames; ++f) {
+        const unsigned bar = unsigned(f * 7) % width;
+        for (unsigned y = 0; y < height; ++y) {
+            uint8_t* p = &rgba[size_t(y) * width * 4];
+            for (unsigned x = 0; x < width; ++x, p += 4) {
+                const bool onBar = x >= bar && x < bar + 16;
+                p[0] = onBar ? 255 : uint8_t(x * 255 / width);
+                p[1] = onBar ? 255 : uint8_t(y * 255 / height);
+                p[2] = onBar ? 0 : uint8_t(f);
+                p[3] = 255;
+            }
+        }
+        auto p0 = clock::now();
+        video.push(rgba.data(), 1, true);
+        const double us = std::chrono::duration<double, std::micro>(clock::now() - p0).count();
+        pushUs += us;
+        worstPushUs = std::max(worstPushUs, us);
+    }
+    const bool ok = video.finish();
+    const double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+    const bool y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    const uint64_t frameBytes = y4m ? 6 + uint64_t(width) * height + 2 * uint64_t((width + 1) / 2) * ((height + 1) / 2)
+                                    : uint64_t(width) * height * 4;
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    const uint64_t fileBytes = uint64_t(in.tellg());
+    const bool sized = fileBytes >= uint64_t(frames) * frameBytes &&
+                       fileBytes - uint64_t(frames) * frameBytes < (y4m ? 96u : 1u);
+
+    std::printf("%d frames %ux%u -> %s (%s), %.1f MB\n", frames, width, height, path.c_str(),
+                y4m ? "Y4M 4:2:0" : "raw RGBA", double(fileBytes) / 1e6);
+    std::printf("main thread: %.0f us per push (worst %.0f), including waits for a free slot\n",
+                pushUs / frames, worstPushUs);
+    std::printf("writer:      %.2f ms per frame, %.0f frames/s overall\n",
+                video.writerBusyMs() / double(std::max<uint64_t>(video.framesWritten(), 1)),
+                frames / std::max(seconds, 1e-9));
+    std::printf("file:        %s\n", ok && sized ? "complete" : "WRONG SIZE OR WRITE ERROR");
+    return ok && sized ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Fills a fresh stats log through the background writer, reloads it, then
+// cuts the last record in half as a crash mid-write would and reloads again
+static int runStatsBench(const std::string& path, uint64_t games) {
+    std::remove(path.c_str());
+    uint64_t expectedBest = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        StatsStore store(path);
+        store.load();
+        store.start();
+        Rng rng(7);
+        for (uint64_t i = 0; i < games; ++i) {
+            GameRecord g;
+            g.seed = rng.next();
+            g.score = uint32_t(rng.below(500));
+            g.ticks = uint32_t(rng.below(20000));
+            g.columns = DEFAULT_COLUMNS;
+            g.rows = DEFAULT_ROWS;
+            g.startingLevel = uint8_t(1 + rng.below(STATS_LEVELS));
+            g.finalLevel = g.startingLevel;
+            store.recordGame(g);
+            expectedBest = std::max<uint64_t>(expectedBest, g.score);
+        }
+    }   // the destructor drains the queue
+    auto t1 = std::chrono::steady_clock::now();
+
+    StatsStore reread(path);
+    bool intact = reread.load();
+    std::cout << games << " games written in "
+              << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms, reloaded in "
+              << reread.loadMicros() << " us: " << reread.state().games << " games, best "
+              << reread.bestScore() << ", " << reread.state().history.size() << " in history\n";
+    if (!intact || reread.state().games != games || reread.bestScore() != expectedBest) {
+        std::cerr << "Error: the reloaded stats do not match what was written\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+    if (bytes.size() > 20) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), std::streamsize(bytes.size() - 20));
+        StatsStore torn(path);
+        bool clean = torn.load();
+        std::cout << "torn tail: " << (clean ? "not detected" : "detected") << ", "
+                  << torn.state().games << " games kept, reloaded in " << torn.loadMicros() << " us\n";
+        if (clean) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static void usage() {
+    std::cerr << "usage: snake_headless bench [ticks] [seed]\n"
+              << "       snake_headless bench-body [moves]\n"
+              << "       snake_headless bench-reach [queries]\n"
+              << "       snake_headless bench-path [games] [astar|hamilton] [obstacles 0|1]\n"
+              << "       snake_headless record <file> [seed] [level]\n"
+              << "       snake_headless replay <file> [runs]\n"
+              << "       snake_headless bench-board [ticks] [wander|greedy|astar]\n"
+              << "       snake_headless bench-fill [ticks]\n"
+              << "       snake_headless batch [games] [threads] [wander|greedy] [seed] [COLSxROWS]\n"
+              << "       snake_headless batch-scale [games] [wander|greedy]\n"
+              << "       snake_headless pack <out.pak> <files...>\n"
+              << "       snake_headless bench-levels [seeds] [COLSxROWS]\n"
+              << "       snake_headless bench-arena [ticks] [agents] [COLSxROWS]\n"
+              << "       snake_headless bench-netplay [ticks] [lagMs] [lossPercent] [tickMs]\n"
+              << "       snake_headless bench-rewind [games]\n"
+              << "       snake_headless bench-video <file.y4m|file.rgba> [frames] [WxH]\n"
+              << "       snake_headless bench-stats <file> [games]\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    std::string cmd = argv[1];
+    if (cmd == "bench") {
+        uint64_t ticks = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+        uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+        return runBench(ticks, seed);
+    }
+    if (cmd == "bench-body") {
+        uint64_t moves = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+        return runBodyBench(moves);
+    }
+    if (cmd == "bench-reach") {
+        uint64_t queries = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+        return runReachBench(queries > 0 ? queries : 1);
+    }
+    if (cmd == "bench-path") {
+        int games = argc > 2 ? std::atoi(argv[2]) : 20;
+        std::string mode = argc > 3 ? argv[3] : "astar";
+        bool obstacles = argc > 4 ? std::atoi(argv[4]) != 0 : true;
+        if (mode != "astar" && mode != "hamilton") {
+            usage();
+            return EXIT_FAILURE;
+        }
+        return runPathBench(games > 0 ? games : 1,
+                            mode == "hamilton" ? Autopilot::HamiltonianCycle : Autopilot::PathToFood,
+                            obstacles);
+    }
+    if (cmd == "bench-board") {
+        uint64_t ticks = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+        Controller bot = findController(argc > 3 ? argv[3] : "greedy");
+        if (!bot) {
+            std::cerr << "Error: unknown bot " << argv[3] << "\n";
+            return EXIT_FAILURE;
+        }
+        return runBoardBench(ticks > 0 ? ticks : 1, bot);
+    }
+    if (cmd == "bench-fill") {
+        uint64_t ticks = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+        return runFillBench(ticks > 0 ? ticks : 1);
+    }
+    if (cmd == "record" && argc > 2) {
+        uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+        int level = argc > 4 ? std::atoi(argv[4]) : 1;
+        return runRecord(argv[2], seed, level);
+    }
+    if (cmd == "pack" && argc > 3) {
+        return runPack(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    }
+    if (cmd == "bench-levels") {
+        int seeds = argc > 2 ? std::atoi(argv[2]) : 200;
+        int columns = DEFAULT_COLUMNS, rows = DEFAULT_ROWS;
+        if (argc > 3 && std::sscanf(argv[3], "%dx%d", &columns, &rows) != 2) {
+            std::cerr << "Error: board size must look like 100x80\n";
+            return EXIT_FAILURE;
+        }
+        columns = std::clamp(columns, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        rows = std::clamp(rows, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        return runLevelBench(seeds > 0 ? seeds : 1, columns, rows);
+    }
+    if (cmd == "bench-arena") {
+        uint64_t ticks = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+        int agents = argc > 3 ? std::atoi(argv[3]) : 500;
+        int columns = 512, rows = 512;
+        if (argc > 4 && std::sscanf(argv[4], "%dx%d", &columns, &rows) != 2) {
+            std::cerr << "Error: board size must look like 100x80\n";
+            return EXIT_FAILURE;
+        }
+        return runArenaBench(ticks > 0 ? ticks : 1, std::clamp(agents, 1, ArenaConfig::MAX_AGENTS),
+                             columns, rows);
+    }
+    if (cmd == "bench-netplay") {
+        int64_t ticks = argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 500;
+        int lag = argc > 3 ? std::atoi(argv[3]) : 50;
+        int loss = argc > 4 ? std::atoi(argv[4]) : 0;
+        int tickMs = argc > 5 ? std::atoi(argv[5]) : 16;
+        return runNetplayBench(std::max<int64_t>(ticks, 1), std::max(lag, 0), loss, std::max(tickMs, 1));
+    }
+    if (cmd == "bench-rewind") {
+        int games = argc > 2 ? std::atoi(argv[2]) : 20;
+        return runRewindBench(games > 0 ? games : 1);
+    }
+    if (cmd == "bench-video" && argc > 2) {
+        int frames = argc > 3 ? std::atoi(argv[3]) : 300;
+        unsigned width = 800, height = 600;
+        if (argc > 4 && (std::sscanf(argv[4], "%ux%u", &width, &height) != 2 || width == 0 || height == 0)) {
+            std::cerr << "Error: frame size must look like 800x600\n";
+            return EXIT_FAILURE;
+        }
+        return runVideoBench(argv[2], frames > 0 ? frames : 1, width, height);
+    }
+    if (cmd == "bench-stats" && argc > 2) {
+        uint64_t games = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000;
+        return runStatsBench(argv[2], games);
+    }
+    if (cmd == "replay" && argc > 2) {
+        int runs = argc > 3 ? std::atoi(argv[3]) : 1;
+        return runReplay(argv[2], runs > 0 ? runs : 1);
+    }
+
+    if (cmd == "batch" || cmd == "batch-scale") {
+        BatchConfig config;
+        int botArg = cmd == "batch" ? 4 : 3;
+        if (argc > 2) config.games = std::strtoull(argv[2], nullptr, 10);
+        if (cmd == "batch" && argc > 3) config.threads = unsigned(std::atoi(argv[3]));
+        if (argc > botArg) config.bot = findController(argv[botArg]);
+        if (cmd == "batch" && argc > 5) config.seed = std::strtoull(argv[5], nullptr, 10);
+        if (cmd == "batch" && argc > 6 &&
+            std::sscanf(argv[6], "%dx%d", &config.columns, &config.rows) != 2)
+        {
+            std::cerr << "Error: board size must look like 100x80\n";
+            return EXIT_FAILURE;
+        }
+        if (!config.bot) {
+            std::cerr << "Error: unknown bot " << argv[botArg] << "\n";
+            return EXIT_FAILURE;
+        }
+        return cmd == "batch" ? runBatchCommand(config) : runBatchScale(config);
+    }
+
+    usage();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,25 @@
+﻿#include "Input.h"
+
+#include <algorithm>
+
+Direction InputQueue::nextTurn(Direction heading) {
+    InputCommand cmd;
+    while (queue.pop(cmd)) {
+        if (cmd.dir == heading || cmd.dir == opposite(heading)) continue;
+
+        int64_t latency = steadyUs() - cmd.pressedUs;
+        latencySumUs += latency;
+        latencyMaxUs = std::max(latencyMaxUs, latency);
+        ++latencySamples;
+        return cmd.dir;
+    }
+    return None;
+}
+
+void InputQueue::summarizeLatency() {
+    avgLatencyMs = latencySamples ? float(latencySumUs) / latencySamples / 1000.f : 0.f;
+    maxLatencyMs = float(latencyMaxUs) / 1000.f;
+    latencySumUs = 0;
+    latencyMaxUs = 0;
+    latencySamples = 0;
+}
@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+#include "SpscQueue.h"
+#include "Util.h"
+
+#include <cstdint>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Buffered direction input
+//
+// Key presses are timestamped and queued instead of overwriting a single
+// pending direction. Each sim tick takes at most one turn, in press order,
+// so two quick presses between ticks become two consecutive moves. Turns
+// are validated against the direction the snake last moved in, which makes
+// it impossible to reverse into the neck through an intermediate press.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct InputCommand {
+    Direction dir = None;
+    int64_t   pressedUs = 0;      // steady-clock timestamp of the key press
+};
+
+class InputQueue {
+public:
+    // Producer side: called from the event loop. Drops the press if the
+    // queue is full (more than a few turns ahead of the snake).
+    void push(Direction d) { queue.push({ d, steadyUs() }); }
+
+    // Consumer side, once per sim tick: returns the next queued turn that is
+    // valid for `heading` (None if there is none) and records its latency.
+    // Presses that would be no-ops or reversals are discarded.
+    Direction nextTurn(Direction heading);
+
+    void clear() { queue.clear(); }
+
+    // Input-to-move latency over the last summary period, in milliseconds
+    float avgLatencyMs = 0.f;
+    float maxLatencyMs = 0.f;
+    void summarizeLatency();
+
+private:
+    SpscQueue<InputCommand, 8> queue;
+    int64_t  latencySumUs = 0;
+    int64_t  latencyMaxUs = 0;
+    unsigned latencySamples = 0;
+};
@@ -0,0 +1,228 @@
+﻿#include "LevelGen.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Generation
+// ─────────────────────────────────────────────────────────────────────────────
+
+int obstacleCount(int columns, int rows, int level) {
+    const long long defaultArea = (DEFAULT_COLUMNS - 2) * (DEFAULT_ROWS - 2);
+    const long long area = (long long)(columns - 2) * (rows - 2);
+    const long long perLevel = std::max(1LL, 2 * area / defaultArea);
+    const long long cap = std::max(perLevel, 40 * area / defaultArea);
+    return int(std::min((long long)std::max(level - 1, 0) * perLevel, cap));
+}
+
+namespace {
+
+enum : uint8_t { Open, Wall, Obstacle };
+
+// The 8 neighbours in ring order; even entries are the 4-neighbours
+const int RING_DX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const int RING_DY[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+struct Board {
+    int cols;
+    int rows;
+    std::vector<uint8_t> cells;
+
+    uint8_t at(int x, int y) const { return cells[size_t(y) * size_t(cols) + size_t(x)]; }
+    uint8_t& at(int x, int y) { return cells[size_t(y) * size_t(cols) + size_t(x)]; }
+
+    int openNeighbours(int x, int y) const {
+        int n = 0;
+        for (int i = 0; i < 8; i += 2) n += at(x + RING_DX[i], y + RING_DY[i]) == Open ? 1 : 0;
+        return n;
+    }
+
+    // Blocking (x, y) keeps every open cell connected if its open
+    // 4-neighbours are joined by one unbroken arc of open cells around it:
+    // any path through (x, y) can then go around instead. The arc must
+    // exist, so the new obstacle keeps an open 4-neighbour.
+    bool arcConnected(int x, int y) const {
+        bool open[8];
+        int firstBlocked = -1;
+        for (int i = 0; i < 8; ++i) {
+            open[i] = at(x + RING_DX[i], y + RING_DY[i]) == Open;
+            if (!open[i] && firstBlocked < 0) firstBlocked = i;
+        }
+        if (firstBlocked < 0) return true;
+
+        int arcs = 0;
+        bool inArc = false;
+        bool arcHasSide = false;
+        for (int k = 1; k <= 8; ++k) {
+            const int i = (firstBlocked + k) & 7;
+            if (open[i]) {
+                inArc = true;
+                arcHasSide = arcHasSide || (i & 1) == 0;
+                continue;
+            }
+            if (inArc && arcHasSide) ++arcs;
+            inArc = false;
+            arcHasSide = false;
+        }
+        return arcs == 1;
+    }
+
+    bool canBlock(int x, int y) const {
+        if (x < 1 || y < 1 || x > cols - 2 || y > rows - 2) return false;
+        if (at(x, y) != Open || !arcConnected(x, y)) return false;
+        // Neighbouring obstacles must keep an open side once this one is down
+        for (int i = 0; i < 8; i += 2) {
+            const int nx = x + RING_DX[i];
+            const int ny = y + RING_DY[i];
+            if (at(nx, ny) == Obstacle && openNeighbours(nx, ny) < 2) return false;
+        }
+        return true;
+    }
+};
+
+Direction perpendicular(Direction d, bool clockwise) {
+    if (d == Up || d == Down) return clockwise ? Right : Left;
+    return clockwise ? Down : Up;
+}
+
+} // namespace
+
+LevelLayout generateLayout(const LayoutKey& key) {
+    LevelLayout layout;
+    layout.key = key;
+
+    const int cols = std::clamp(key.columns, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+    const int rows = std::clamp(key.rows, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+    const size_t count = size_t(obstacleCount(cols, rows, key.level));
+    if (count == 0) return layout;
+    layout.obstacles.reserve(count);
+
+    Board board{ cols, rows, std::vector<uint8_t>(size_t(cols) * size_t(rows), Open) };
+    for (int x = 0; x < cols; ++x) board.at(x, 0) = board.at(x, rows - 1) = Wall;
+    for (int y = 0; y < rows; ++y) board.at(0, y) = board.at(cols - 1, y) = Wall;
+
+    // Same rules as the snake's start position in SnakeSim
+    const Cell start{ cols / 2, rows / 2 };
+
+    // Pieces of 1-4 cells: a bar, bent into a corner after two cells half
+    // the time. A piece stops at the first cell that breaks a rule; the
+    // attempt limit ends the loop on boards too crowded to reach `count`.
+    Rng rng(key.seed + uint64_t(key.level) * 0x9E3779B97F4A7C15ull);
+    const size_t maxAttempts = count * 16 + 64;
+    for (size_t attempt = 0; layout.obstacles.size() < count && attempt < maxAttempts; ++attempt) {
+        Cell c{ 1 + int(rng.below(uint32_t(cols - 2))), 1 + int(rng.below(uint32_t(rows - 2))) };
+        const int length = 1 + int(rng.below(4));
+        Direction d = Direction(Up + int(rng.below(4)));
+        const bool bend = rng.below(2) != 0;
+        const bool clockwise = rng.below(2) != 0;
+
+        for (int i = 0; i < length && layout.obstacles.size() < count; ++i) {
+            if (std::abs(c.x - start.x) < 5 && std::abs(c.y - start.y) < 5) break;
+            if (!board.canBlock(c.x, c.y)) break;
+            board.at(c.x, c.y) = Obstacle;
+            layout.obstacles.push_back(c);
+            if (i == 1 && bend) d = perpendicular(d, clockwise);
+            c = advance(c, d);
+        }
+    }
+    return layout;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// LayoutCache
+// ─────────────────────────────────────────────────────────────────────────────
+
+LayoutCache::LayoutCache(size_t capacity)
+    : capacity(std::max<size_t>(capacity, 1))
+{
+}
+
+LayoutCache::~LayoutCache() {
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        stopping = true;
+        queue.clear();
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void LayoutCache::prefetch(const LayoutKey& key) {
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        const bool cached = std::any_of(entries.begin(), entries.end(),
+                                        [&](const Entry& e) { return e.layout->key == key; });
+        if (cached || (busy && current == key) ||
+            std::find(queue.begin(), queue.end(), key) != queue.end())
+        {
+            return;
+        }
+        queue.push_back(key);
+        if (!worker.joinable()) worker = std::thread(&LayoutCache::workerLoop, this);
+    }
+    wake.notify_one();
+}
+
+std::shared_ptr<const LevelLayout> LayoutCache::get(const LayoutKey& key) {
+    std::unique_lock<std::mutex> hold(lock);
+    built.wait(hold, [&] { return !(busy && current == key); });
+    if (auto layout = lookup(key)) {
+        ++hitCount;
+        return layout;
+    }
+
+    // Not prefetched (or evicted): build it here rather than queue behind
+    // other work
+    ++missCount;
+    queue.erase(std::remove(queue.begin(), queue.end(), key), queue.end());
+    hold.unlock();
+    auto layout = std::make_shared<const LevelLayout>(generateLayout(key));
+    hold.lock();
+    insert(layout);
+    return layout;
+}
+
+void LayoutCache::workerLoop() {
+    std::unique_lock<std::mutex> hold(lock);
+    for (;;) {
+        wake.wait(hold, [&] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        const LayoutKey key = queue.front();
+        queue.erase(queue.begin());
+        current = key;
+        busy = true;
+
+        hold.unlock();
+        auto layout = std::make_shared<const LevelLayout>(generateLayout(key));
+        hold.lock();
+
+        insert(std::move(layout));
+        busy = false;
+        built.notify_all();
+    }
+}
+
+void LayoutCache::insert(std::shared_ptr<const LevelLayout> layout) {
+    for (Entry& e : entries) {
+        if (e.layout->key == layout->key) {
+            e.lastUse = ++useClock;
+            return;
+        }
+    }
+    if (entries.size() >= capacity) {
+        auto oldest = std::min_element(entries.begin(), entries.end(),
+                                       [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+        entries.erase(oldest);
+    }
+    entries.push_back({ std::move(layout), ++useClock });
+}
+
+std::shared_ptr<const LevelLayout> LayoutCache::lookup(const LayoutKey& key) {
+    for (Entry& e : entries) {
+        if (e.layout->key == key) {
+            e.lastUse = ++useClock;
+            return e.layout;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Level layouts
+//
+// The obstacles of a level, generated from (board size, level, seed) alone,
+// so a layout can be built ahead of time on another thread and still be the
+// same one the sim would have built itself.
+//
+// Obstacles go down as short bars and corners. A cell is only accepted if
+//   - the free cells around it stay connected through its 8-neighbourhood
+//     (so every free cell on the board stays reachable from every other), and
+//   - it and each obstacle next to it keep at least one free 4-neighbour.
+// The second rule means any subset of a layout can be left out (where the
+// snake or the food is when a level starts) without sealing off a pocket.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct LayoutKey {
+    int      columns = DEFAULT_COLUMNS;
+    int      rows = DEFAULT_ROWS;
+    int      level = 1;
+    uint64_t seed = 0;                  // drawn by SnakeSim::reset() once per game
+
+    bool operator==(const LayoutKey& o) const {
+        return columns == o.columns && rows == o.rows && level == o.level && seed == o.seed;
+    }
+};
+
+struct LevelLayout {
+    LayoutKey         key;
+    std::vector<Cell> obstacles;        // in placement order
+};
+
+// Obstacles for a level: two more per level up to 40 on the default board,
+// other boards get the same density scaled by interior area
+int obstacleCount(int columns, int rows, int level);
+
+// Deterministic in `key`; the cells around the board centre (the snake's
+// start) are always left clear
+LevelLayout generateLayout(const LayoutKey& key);
+
+// Recently used layouts plus a worker thread that builds requested ones in
+// the background, so a level-up only has to copy cells onto the board.
+class LayoutCache {
+public:
+    explicit LayoutCache(size_t capacity = 8);
+    ~LayoutCache();                     // abandons queued work, joins the worker
+
+    LayoutCache(const LayoutCache&) = delete;
+    LayoutCache& operator=(const LayoutCache&) = delete;
+
+    // Queue `key` for the worker unless it is cached or already queued
+    void prefetch(const LayoutKey& key);
+
+    // The layout for `key`: from the cache, after waiting for the worker if
+    // it is building it, or generated on the calling thread otherwise
+    std::shared_ptr<const LevelLayout> get(const LayoutKey& key);
+
+    uint64_t hits() const { return hitCount; }
+    uint64_t misses() const { return missCount; }
+
+private:
+    struct Entry {
+        std::shared_ptr<const LevelLayout> layout;
+        uint64_t lastUse;
+    };
+
+    void workerLoop();
+    void insert(std::shared_ptr<const LevelLayout> layout);   // lock held
+    std::shared_ptr<const LevelLayout> lookup(const LayoutKey& key);   // lock held
+
+    size_t                 capacity;
+    std::mutex             lock;
+    std::condition_variable wake;       // work queued, or the cache is stopping
+    std::condition_variable built;      // the worker finished a layout
+    std::vector<Entry>     entries;
+    std::vector<LayoutKey> queue;
+    bool                   busy = false;    // the worker is building `current`
+    LayoutKey              current;
+    bool                   stopping = false;
+    uint64_t               useClock = 0;
+    uint64_t               hitCount = 0;
+    uint64_t               missCount = 0;
+    std::thread            worker;
+};
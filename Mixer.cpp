@@ -0,0 +1,85 @@
+﻿#include "Mixer.h"
+
+SfxMixer::SfxMixer(int maxActive)
+    : maxActive(maxActive)
+{
+    voices.reserve(MAX_VOICES);
+}
+
+void SfxMixer::addEffect(SoundEffect effect, const sf::SoundBuffer& buffer, int count,
+                         int prio, float pitch, float volume)
+{
+    priority[effect] = prio;
+    for (int i = 0; i < count && voices.size() < MAX_VOICES; ++i) {
+        voices.emplace_back(buffer);
+        Voice& v = voices.back();
+        v.effect = effect;
+        v.sound.setPitch(pitch);
+        v.sound.setVolume(volume);
+    }
+}
+
+void SfxMixer::update() {
+    bool wanted[SFX_COUNT] = {};
+    SoundEffect e;
+    while (requests.pop(e)) wanted[e] = true;
+
+    // Highest priority first, so it gets first pick of the voices
+    for (;;) {
+        int best = -1;
+        for (int i = 0; i < SFX_COUNT; ++i) {
+            if (wanted[i] && (best < 0 || priority[i] > priority[best])) best = i;
+        }
+        if (best < 0) break;
+        wanted[best] = false;
+        dispatch(SoundEffect(best));
+    }
+}
+
+void SfxMixer::dispatch(SoundEffect effect) {
+    // A free voice of this effect, else its oldest one (overlap is capped
+    // at the effect's voice count)
+    bool   busy[MAX_VOICES];
+    int    active = 0;
+    Voice* voice = nullptr;
+    bool   voiceBusy = true;
+    for (size_t i = 0; i < voices.size(); ++i) {
+        Voice& v = voices[i];
+        busy[i] = playing(v);
+        active += busy[i] ? 1 : 0;
+        if (v.effect != effect) continue;
+        if (!voice || (voiceBusy && (!busy[i] || v.started < voice->started))) {
+            voice = &v;
+            voiceBusy = busy[i];
+        }
+    }
+    if (!voice) return;
+
+    // Over the global limit: cut the oldest lower-priority voice, else
+    // restart this effect's oldest playing voice, else give up
+    if (!voiceBusy && active >= maxActive) {
+        Voice* victim = nullptr;
+        Voice* own = nullptr;
+        for (size_t i = 0; i < voices.size(); ++i) {
+            Voice& v = voices[i];
+            if (!busy[i]) continue;
+            if (v.effect == effect && (!own || v.started < own->started)) own = &v;
+            if (priority[v.effect] >= priority[effect]) continue;
+            if (!victim || v.started < victim->started) victim = &v;
+        }
+        if (victim) {
+            victim->sound.stop();
+        }
+        else if (own) {
+            voice = own;
+        }
+        else {
+            ++droppedCount;
+            return;
+        }
+    }
+
+    voice->sound.stop();
+    voice->sound.play();
+    voice->started = ++sequence;
+}
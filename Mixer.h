@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include "SpscQueue.h"
+
+#include <SFML/Audio.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sound effect mixer
+//
+// A fixed pool of voices (sf::Sound), each bound to one effect's buffer when
+// the mixer is set up, so playing never rebinds a buffer or allocates.
+// Several voices per effect let rapid eats overlap instead of restarting one
+// sound. Sim ticks only queue requests; update() dispatches them once per
+// frame, merging repeats of the same effect in that frame (a fast replay
+// can eat many times per frame).
+//
+// When more than maxActive voices would play, the oldest playing voice of
+// lower priority is cut, or failing that the effect's own oldest voice is
+// restarted; if neither exists, the request is dropped.
+// ─────────────────────────────────────────────────────────────────────────────
+
+enum SoundEffect { SfxEat, SfxBonus, SfxGameOver, SFX_COUNT };
+
+class SfxMixer {
+public:
+    static const int MAX_VOICES = 16;
+
+    explicit SfxMixer(int maxActive = 6);
+
+    // Setup: `voices` voices for `effect`, all playing `buffer` (which must
+    // outlive the mixer). Higher priority wins when voices run out.
+    void addEffect(SoundEffect effect, const sf::SoundBuffer& buffer, int voices,
+                   int priority, float pitch = 1.f, float volume = 100.f);
+
+    // Game thread, any number of times per tick: O(1), no SFML calls
+    void play(SoundEffect effect) { requests.push(effect); }
+
+    // Once per frame: start the sounds requested since the last update
+    void update();
+
+    // Requests dropped because no voice could be freed for them
+    uint64_t dropped() const { return droppedCount; }
+
+private:
+    struct Voice {
+        explicit Voice(const sf::SoundBuffer& b) : sound(b) {}
+        sf::Sound   sound;
+        SoundEffect effect = SfxEat;
+        uint64_t    started = 0;        // dispatch sequence number, 0 = never
+    };
+
+    bool playing(const Voice& v) const { return v.sound.getStatus() == sf::Sound::Status::Playing; }
+    void dispatch(SoundEffect effect);
+
+    std::vector<Voice> voices;          // reserved for MAX_VOICES: never reallocates
+    int      priority[SFX_COUNT] = {};
+    int      maxActive;
+    uint64_t sequence = 0;
+    uint64_t droppedCount = 0;
+    SpscQueue<SoundEffect, 32> requests;
+};
@@ -0,0 +1,147 @@
+﻿#include "NetSocket.h"
+
+#include "Util.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Winsock needs starting once per process; a static does it on first use
+static bool socketsReady() {
+#if defined(_WIN32)
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+#else
+    return true;
+#endif
+}
+
+static sockaddr_in toSockaddr(const NetAddress& a) {
+    sockaddr_in s{};
+    s.sin_family = AF_INET;
+    s.sin_addr.s_addr = htonl(a.ip);
+    s.sin_port = htons(a.port);
+    return s;
+}
+
+bool resolveAddress(const std::string& hostPort, NetAddress& out) {
+    const size_t colon = hostPort.rfind(':');
+    if (colon == std::string::npos || colon == 0 || !socketsReady()) return false;
+    const int port = std::atoi(hostPort.c_str() + colon + 1);
+    if (port <= 0 || port > 0xFFFF) return false;
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(hostPort.substr(0, colon).c_str(), nullptr, &hints, &found) != 0 || !found) return false;
+    out.ip = ntohl(reinterpret_cast<const sockaddr_in*>(found->ai_addr)->sin_addr.s_addr);
+    out.port = uint16_t(port);
+    freeaddrinfo(found);
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// UdpSocket
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool UdpSocket::open(uint16_t port) {
+    close();
+    if (!socketsReady()) return false;
+    handle = Handle(::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    if (handle == INVALID) return false;
+
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    const bool configured = ioctlsocket(SOCKET(handle), FIONBIO, &nonBlocking) == 0;
+#else
+    const bool configured = fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    sockaddr_in local = toSockaddr({ INADDR_ANY, port });
+    socklen_t length = sizeof local;
+    if (!configured ||
+        ::bind(handle, reinterpret_cast<const sockaddr*>(&local), sizeof local) != 0 ||
+        ::getsockname(handle, reinterpret_cast<sockaddr*>(&local), &length) != 0)
+    {
+        close();
+        return false;
+    }
+    boundPort = ntohs(local.sin_port);
+    return true;
+}
+
+void UdpSocket::close() {
+    if (handle == INVALID) return;
+#if defined(_WIN32)
+    ::closesocket(SOCKET(handle));
+#else
+    ::close(handle);
+#endif
+    handle = INVALID;
+    boundPort = 0;
+    held.clear();
+}
+
+void UdpSocket::setLag(int delayMs, int jitter, int loss, uint64_t seed) {
+    lagUs = std::max(delayMs, 0) * 1000;
+    jitterUs = std::max(jitter, 0) * 1000;
+    lossPercent = std::clamp(loss, 0, 100);
+    lagRng.reseed(seed);
+}
+
+bool UdpSocket::sendNow(const NetAddress& to, const uint8_t* data, size_t size) {
+    const sockaddr_in dest = toSockaddr(to);
+    return ::sendto(handle, reinterpret_cast<const char*>(data), int(size), 0,
+                    reinterpret_cast<const sockaddr*>(&dest), sizeof dest) == int(size);
+}
+
+bool UdpSocket::send(const NetAddress& to, const uint8_t* data, size_t size) {
+    if (handle == INVALID) return false;
+    if (lagUs == 0 && jitterUs == 0 && lossPercent == 0) return sendNow(to, data, size);
+
+    // Dropped packets count as sent, as they would on a real network
+    if (lossPercent > 0 && int(lagRng.below(100)) < lossPercent) return true;
+    int64_t due = steadyUs() + lagUs + (jitterUs > 0 ? int64_t(lagRng.below(uint32_t(jitterUs))) : 0);
+    if (!held.empty()) due = std::max(due, held.back().dueUs);
+    held.push_back({ due, to, std::vector<uint8_t>(data, data + size) });
+    flush();
+    return true;
+}
+
+void UdpSocket::flush() {
+    const int64_t now = steadyUs();
+    while (!held.empty() && held.front().dueUs <= now) {
+        sendNow(held.front().to, held.front().bytes.data(), held.front().bytes.size());
+        held.pop_front();
+    }
+}
+
+int UdpSocket::receive(uint8_t* buffer, size_t capacity, NetAddress& from) {
+    if (handle == INVALID) return -1;
+    flush();
+    sockaddr_in source{};
+    socklen_t length = sizeof source;
+    const auto got = ::recvfrom(handle, reinterpret_cast<char*>(buffer), int(capacity), 0,
+                                reinterpret_cast<sockaddr*>(&source), &length);
+    if (got < 0) return -1;     // nothing waiting (or an ICMP error from a closed peer)
+    from.ip = ntohl(source.sin_addr.s_addr);
+    from.port = ntohs(source.sin_port);
+    return int(got);
+}
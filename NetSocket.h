@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// UDP socket
+//
+// A non-blocking IPv4 datagram socket (Winsock or BSD sockets), just enough
+// for two peers to swap small packets. For testing on one machine it can
+// hold every outgoing packet back for a simulated latency, with jitter and
+// loss, so a loopback game behaves like one over a real network.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct NetAddress {
+    uint32_t ip = 0;        // host byte order
+    uint16_t port = 0;
+
+    bool operator==(const NetAddress& o) const { return ip == o.ip && port == o.port; }
+    bool operator!=(const NetAddress& o) const { return !(*this == o); }
+};
+
+// "host:port" (a name or dotted quad) to an address; false if it doesn't resolve
+bool resolveAddress(const std::string& hostPort, NetAddress& out);
+
+class UdpSocket {
+public:
+    UdpSocket() = default;
+    ~UdpSocket() { close(); }
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // Binds every interface on `port` (0 picks a free one)
+    bool open(uint16_t port);
+    void close();
+    bool isOpen() const { return handle != INVALID; }
+    uint16_t localPort() const { return boundPort; }
+
+    // Sends now, or queues the packet when a simulated lag is set
+    bool send(const NetAddress& to, const uint8_t* data, size_t size);
+
+    // Next waiting datagram; returns its size, or -1 when there is none
+    int  receive(uint8_t* buffer, size_t capacity, NetAddress& from);
+
+    // Outgoing packets wait delayMs (± jitterMs) and lossPercent of them are
+    // dropped. Packets are never reordered, as on a typical local link.
+    void setLag(int delayMs, int jitterMs = 0, int lossPercent = 0, uint64_t seed = 1);
+
+    // Sends the held-back packets that are due; send() and receive() call it
+    void flush();
+
+private:
+    struct Held {
+        int64_t              dueUs;
+        NetAddress           to;
+        std::vector<uint8_t> bytes;
+    };
+
+    bool sendNow(const NetAddress& to, const uint8_t* data, size_t size);
+
+#if defined(_WIN32)
+    using Handle = uintptr_t;
+#else
+    using Handle = int;
+#endif
+    static constexpr Handle INVALID = Handle(~Handle(0));
+
+    Handle           handle = INVALID;
+    uint16_t         boundPort = 0;
+    int              lagUs = 0;
+    int              jitterUs = 0;
+    int              lossPercent = 0;
+    Rng              lagRng;
+    std::deque<Held> held;
+};
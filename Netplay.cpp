@@ -0,0 +1,331 @@
+﻿#include "Netplay.h"
+
+#include "Util.h"
+
+#include <cstring>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Packets: "SNKN", version, type, then
+//   Hello    (joiner -> host, until Start arrives)
+//   Start    seed u64, columns u16, rows u16, food u16, respawnTicks u16, startLength u16
+//   Inputs   ack u32 (ticks of the receiver's turns we have), frame u32,
+//            advantage i8, check frame u32, checksum u64, first tick u32,
+//            count u8, one Direction byte per tick
+//   Bye      (leaving)
+// All integers little-endian.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const uint8_t NET_MAGIC[4] = { 'S', 'N', 'K', 'N' };
+static const uint8_t NET_VERSION = 1;
+static const size_t  NET_HEADER = 6;
+static const size_t  MAX_PACKET = 512;
+static const int     HELLO_MS = 100;       // joiner's retry interval
+static const int     KEEPALIVE_MS = 50;    // turns are re-sent at least this often
+static const int     FINISH_REPEATS = 4;
+
+enum : uint8_t { PacketHello = 1, PacketStart, PacketInputs, PacketBye };
+
+static void putHeader(std::vector<uint8_t>& out, uint8_t type) {
+    out.assign(NET_MAGIC, NET_MAGIC + 4);
+    out.push_back(NET_VERSION);
+    out.push_back(type);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Session
+// ─────────────────────────────────────────────────────────────────────────────
+
+VersusSession::VersusSession() {
+    reset(ArenaConfig(), 1);
+}
+
+void VersusSession::reset(const ArenaConfig& config, uint64_t s) {
+    arenaConfig = config;
+    arenaConfig.agents = 2;
+    seed = s;
+    current.reseed(seed);
+    current.reset(arenaConfig);
+    snapshots.assign(MAX_ROLLBACK + 1, current);
+    tickInputs.assign(2, None);
+
+    frameCount = 0;
+    std::fill(std::begin(localTurns), std::end(localTurns), None);
+    std::fill(std::begin(remoteTurns), std::end(remoteTurns), None);
+    std::fill(std::begin(remoteUsed), std::end(remoteUsed), None);
+    localEnd = INPUT_DELAY;     // the first ticks have no turn on either side
+    remoteEnd = 0;
+    peerAck = 0;
+    rollbackFrom = -1;
+    peerFrame = 0;
+    peerAdvantage = 0;
+    lastSkip = 0;
+    std::fill(std::begin(checkFrames), std::end(checkFrames), -1);
+    checkedUpTo = 0;
+    peerCheckFrame = -1;
+    desync = false;
+    rollbackCount = resimulated = waitCount = skipCount = 0;
+    deepest = 0;
+}
+
+bool VersusSession::host(uint16_t port, const ArenaConfig& config, uint64_t s) {
+    close();
+    side = 0;
+    reset(config, s);
+    if (!socket.open(port)) return false;
+    state = NetConnecting;
+    return true;
+}
+
+bool VersusSession::join(const NetAddress& hostAddress) {
+    close();
+    side = 1;
+    peer = hostAddress;
+    if (!socket.open(0)) return false;
+    state = NetConnecting;
+    lastSentUs = 0;
+    return true;
+}
+
+void VersusSession::close() {
+    if (state == NetRunning) sendControl(PacketBye);
+    socket.close();
+    state = NetIdle;
+}
+
+void VersusSession::finish() {
+    if (state != NetRunning) return;
+    for (int i = 0; i < FINISH_REPEATS; ++i) sendInputs();
+}
+
+const ArenaSim& VersusSession::confirmed() const {
+    const int64_t f = confirmedFrame();
+    return f == frameCount ? current : snapshots[size_t(f % int64_t(snapshots.size()))];
+}
+
+Direction VersusSession::plannedHeading() const {
+    Direction d = current.heading(side);
+    for (int64_t f = frameCount; f < localEnd; ++f) {
+        const Direction t = localTurns[f % INPUT_RING];
+        if (t != None && (t != opposite(d) || current.length(side) == 1)) d = t;
+    }
+    return d;
+}
+
+int VersusSession::loser(int lives) const {
+    const ArenaSim& c = confirmed();
+    const bool first = c.deaths(0) >= uint32_t(lives);
+    const bool second = c.deaths(1) >= uint32_t(lives);
+    if (first && second) return 2;
+    return first ? 0 : second ? 1 : -1;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Ticks
+// ─────────────────────────────────────────────────────────────────────────────
+
+void VersusSession::poll() {
+    if (state != NetConnecting && state != NetRunning) return;
+    receive();
+    rollback();
+    confirm();
+
+    const int64_t now = steadyUs();
+    if (state == NetConnecting && side == 1 && now - lastSentUs >= HELLO_MS * 1000) {
+        sendControl(PacketHello);
+        lastSentUs = now;
+    }
+    if (state == NetRunning) {
+        if (now - lastHeardUs > int64_t(DISCONNECT_MS) * 1000) {
+            state = NetDisconnected;
+            return;
+        }
+        if (now - lastSentUs >= KEEPALIVE_MS * 1000) sendInputs();
+    }
+}
+
+bool VersusSession::advance(Direction turn) {
+    if (state != NetRunning) return false;
+    receive();
+    rollback();
+
+    // Too far past the last turn we have from the peer, or it hasn't
+    // acknowledged enough of ours to keep them all for resending
+    if (frameCount - remoteEnd >= MAX_ROLLBACK || localEnd - peerAck >= INPUT_RING - 1) {
+        ++waitCount;
+        return false;
+    }
+    // Advantages are both off by the one-way latency, which cancels: the
+    // difference is twice how many ticks we are ahead
+    const int64_t advantage = frameCount - peerFrame;
+    if (advantage - peerAdvantage >= 2 && frameCount - lastSkip >= MAX_ROLLBACK) {
+        lastSkip = frameCount;
+        ++skipCount;
+        return false;
+    }
+
+    localTurns[localEnd % INPUT_RING] = turn;
+    ++localEnd;
+    stepFrame(frameCount);
+    ++frameCount;
+    confirm();
+    sendInputs();
+    return true;
+}
+
+void VersusSession::stepFrame(int64_t f) {
+    const size_t slot = size_t(f % INPUT_RING);
+    const Direction remote = f < remoteEnd ? remoteTurns[slot] : None;   // prediction: no turn
+    remoteUsed[slot] = remote;
+    tickInputs[side] = localTurns[slot];
+    tickInputs[1 - side] = remote;
+    snapshots[size_t(f % int64_t(snapshots.size()))] = current;
+    current.step(tickInputs);
+}
+
+void VersusSession::rollback() {
+    if (rollbackFrom < 0) return;
+    const int64_t from = rollbackFrom;
+    rollbackFrom = -1;
+    current = snapshots[size_t(from % int64_t(snapshots.size()))];
+    for (int64_t f = from; f < frameCount; ++f) stepFrame(f);
+
+    ++rollbackCount;
+    resimulated += uint64_t(frameCount - from);
+    deepest = std::max(deepest, int(frameCount - from));
+}
+
+void VersusSession::confirm() {
+    const int64_t upTo = confirmedFrame();
+    for (int64_t f = (checkedUpTo / CHECK_INTERVAL + 1) * CHECK_INTERVAL; f <= upTo; f += CHECK_INTERVAL) {
+        const ArenaSim& at = f == frameCount ? current : snapshots[size_t(f % int64_t(snapshots.size()))];
+        const size_t slot = size_t(f / CHECK_INTERVAL % CHECK_RING);
+        checkFrames[slot] = f;
+        checkSums[slot] = at.checksum();
+    }
+    checkedUpTo = std::max(checkedUpTo, upTo);
+    compareChecksums();
+}
+
+void VersusSession::compareChecksums() {
+    if (peerCheckFrame <= 0) return;
+    const size_t slot = size_t(peerCheckFrame / CHECK_INTERVAL % CHECK_RING);
+    if (checkFrames[slot] == peerCheckFrame && checkSums[slot] != peerCheckSum) desync = true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Network
+// ─────────────────────────────────────────────────────────────────────────────
+
+void VersusSession::sendControl(uint8_t type) {
+    std::vector<uint8_t> out;
+    putHeader(out, type);
+    if (type == PacketStart) {
+        putLe(out, seed, 8);
+        putLe(out, uint64_t(arenaConfig.columns), 2);
+        putLe(out, uint64_t(arenaConfig.rows), 2);
+        putLe(out, uint64_t(arenaConfig.food), 2);
+        putLe(out, uint64_t(arenaConfig.respawnTicks), 2);
+        putLe(out, uint64_t(arenaConfig.startLength), 2);
+    }
+    socket.send(peer, out.data(), out.size());
+}
+
+void VersusSession::sendInputs() {
+    // Our latest confirmed checksum, for the peer to compare
+    const int64_t checkFrame = checkedUpTo / CHECK_INTERVAL * CHECK_INTERVAL;
+    const size_t checkSlot = size_t(checkFrame / CHECK_INTERVAL % CHECK_RING);
+    const bool haveCheck = checkFrame > 0 && checkFrames[checkSlot] == checkFrame;
+
+    std::vector<uint8_t> out;
+    out.reserve(MAX_PACKET);
+    putHeader(out, PacketInputs);
+    putLe(out, uint64_t(remoteEnd), 4);
+    putLe(out, uint64_t(frameCount), 4);
+    out.push_back(uint8_t(int8_t(std::clamp<int64_t>(frameCount - peerFrame, -127, 127))));
+    putLe(out, haveCheck ? uint64_t(checkFrame) : 0, 4);
+    putLe(out, haveCheck ? checkSums[checkSlot] : 0, 8);
+    putLe(out, uint64_t(peerAck), 4);
+    out.push_back(uint8_t(localEnd - peerAck));
+    for (int64_t f = peerAck; f < localEnd; ++f) out.push_back(uint8_t(localTurns[f % INPUT_RING]));
+    socket.send(peer, out.data(), out.size());
+    lastSentUs = steadyUs();
+}
+
+void VersusSession::receive() {
+    uint8_t buffer[MAX_PACKET];
+    NetAddress from;
+    int size;
+    while ((size = socket.receive(buffer, sizeof buffer, from)) >= 0) {
+        if (size_t(size) < NET_HEADER || std::memcmp(buffer, NET_MAGIC, 4) != 0 || buffer[4] != NET_VERSION) {
+            continue;
+        }
+        const uint8_t type = buffer[5];
+        const uint8_t* body = buffer + NET_HEADER;
+        const size_t bodySize = size_t(size) - NET_HEADER;
+
+        // The host takes the first joiner that says hello and ignores the rest
+        if (type == PacketHello && side == 0) {
+            if (state == NetConnecting) {
+                peer = from;
+                state = NetRunning;
+            }
+            if (from == peer) sendControl(PacketStart);
+        }
+        if (from != peer) continue;
+        lastHeardUs = steadyUs();
+
+        if (type == PacketStart && side == 1 && state == NetConnecting && bodySize >= 18) {
+            ArenaConfig config;
+            config.columns = int(readLe(body + 8, 2));
+            config.rows = int(readLe(body + 10, 2));
+            config.food = int(readLe(body + 12, 2));
+            config.respawnTicks = int(readLe(body + 14, 2));
+            config.startLength = int(readLe(body + 16, 2));
+            reset(config, readLe(body, 8));
+            state = NetRunning;
+        }
+        else if (type == PacketInputs && state == NetRunning) {
+            handleInputs(body, bodySize);
+        }
+        else if (type == PacketBye && state == NetRunning) {
+            state = NetDisconnected;
+        }
+    }
+}
+
+void VersusSession::handleInputs(const uint8_t* p, size_t size) {
+    if (size < 26) return;
+    const int64_t ack = int64_t(readLe(p, 4));
+    const int64_t theirFrame = int64_t(readLe(p + 4, 4));
+    const int advantage = int8_t(p[8]);
+    const int64_t checkFrame = int64_t(readLe(p + 9, 4));
+    const uint64_t checkSum = readLe(p + 13, 8);
+    const int64_t first = int64_t(readLe(p + 21, 4));
+    const size_t count = std::min<size_t>(p[25], size - 26);
+    const uint8_t* turns = p + 26;
+
+    peerAck = std::clamp(ack, peerAck, localEnd);
+    if (theirFrame >= peerFrame) {
+        peerFrame = theirFrame;
+        peerAdvantage = advantage;
+    }
+    if (checkFrame > peerCheckFrame) {
+        peerCheckFrame = checkFrame;
+        peerCheckSum = checkSum;
+    }
+
+    // Turns arrive in order from the first one we lack; a tick we have
+    // simulated with a different prediction is rolled back to
+    for (size_t k = 0; k < count; ++k) {
+        const int64_t f = first + int64_t(k);
+        if (f < remoteEnd) continue;
+        if (f > remoteEnd || f >= frameCount - MAX_ROLLBACK + INPUT_RING || turns[k] > Right) break;
+        const Direction d = Direction(turns[k]);
+        const size_t slot = size_t(f % INPUT_RING);
+        remoteTurns[slot] = d;
+        if (f < frameCount && remoteUsed[slot] != d && (rollbackFrom < 0 || f < rollbackFrom)) {
+            rollbackFrom = f;
+        }
+        ++remoteEnd;
+    }
+}
@@ -0,0 +1,150 @@
+﻿#pragma once
+
+#include "ArenaSim.h"
+#include "NetSocket.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Two-player versus with rollback
+//
+// Both peers run the same arena (two agents, no bots) from the same seed and
+// send each other nothing but their own per-tick turns. A tick never waits
+// for the other player's turn to arrive: it is predicted (no turn, i.e. keep
+// going straight), and when the real turn turns out to differ, the arena is
+// restored from the snapshot taken before that tick and the ticks since are
+// simulated again. Local input therefore takes effect at local latency; the
+// other snake may visibly jump by a cell or two when a prediction is fixed.
+//
+//   - Snapshots are whole ArenaSim copies in a ring of MAX_ROLLBACK + 1;
+//     the ring is filled once, so later copies reuse its buffers.
+//   - Every packet repeats all turns the peer hasn't acknowledged, so a lost
+//     packet costs nothing but the wait for the next one.
+//   - A peer more than MAX_ROLLBACK ticks ahead of the turns it has waits;
+//     one that runs ahead of the other in time skips a tick now and then so
+//     the two clocks don't drift apart.
+//   - Checksums of confirmed ticks are exchanged to catch a desync.
+//
+// Host (agent 0) picks the seed and the board; the joiner (agent 1) takes
+// them from the host's Start packet.
+// ─────────────────────────────────────────────────────────────────────────────
+
+enum NetStatus { NetIdle, NetConnecting, NetRunning, NetDisconnected };
+
+class VersusSession {
+public:
+    static const int MAX_ROLLBACK = 8;          // ticks a prediction may run ahead
+    static const int INPUT_DELAY = 1;           // local turns apply this many ticks late
+    static const int DISCONNECT_MS = 3000;      // silence before the peer counts as gone
+
+    VersusSession();
+    ~VersusSession() { close(); }
+
+    VersusSession(const VersusSession&) = delete;
+    VersusSession& operator=(const VersusSession&) = delete;
+
+    // Listen on `port` for a joiner; agent 0. `config.agents` is forced to 2.
+    bool host(uint16_t port, const ArenaConfig& config, uint64_t seed);
+    // Connect to a host; agent 1
+    bool join(const NetAddress& hostAddress);
+    void close();
+
+    // Simulated network delay on this side's outgoing packets (see UdpSocket)
+    void setLag(int delayMs, int jitterMs = 0, int lossPercent = 0) {
+        socket.setLag(delayMs, jitterMs, lossPercent, uint64_t(side) + 1);
+    }
+
+    // Handshake, incoming turns and keep-alives; call every frame
+    void poll();
+
+    // One tick with this player's turn. Returns false (and takes no turn)
+    // when the tick has to wait for the peer; try again next tick.
+    bool advance(Direction turn);
+
+    // Sends the last turns a few more times, for a peer still catching up
+    // after this side has stopped ticking (end of match)
+    void finish();
+
+    NetStatus status() const { return state; }
+    uint16_t  localPort() const { return socket.localPort(); }
+    int       localAgent() const { return side; }
+    int       remoteAgent() const { return 1 - side; }
+
+    // The present, including predicted turns
+    const ArenaSim& sim() const { return current; }
+    // This player's heading once the turns already taken (which apply
+    // INPUT_DELAY ticks late) are in; what the next turn is checked against
+    Direction plannedHeading() const;
+    // The last tick for which both players' turns are known
+    const ArenaSim& confirmed() const;
+    int64_t   frame() const { return frameCount; }
+    int64_t   confirmedFrame() const { return std::min(frameCount, remoteEnd); }
+
+    // First player to lose all `lives`, judged on confirmed ticks only so
+    // both sides agree: -1 while the match is on, 2 for a draw
+    int       loser(int lives) const;
+
+    bool      desynced() const { return desync; }
+    uint64_t  rollbacks() const { return rollbackCount; }
+    uint64_t  resimulatedTicks() const { return resimulated; }
+    int       deepestRollback() const { return deepest; }
+    uint64_t  waits() const { return waitCount; }
+    uint64_t  timeSyncSkips() const { return skipCount; }
+
+private:
+    static const int INPUT_RING = 64;           // turns kept per player
+    static const int CHECK_RING = 16;           // confirmed checksums kept
+    static const int CHECK_INTERVAL = 8;        // ticks between them
+
+    void reset(const ArenaConfig& config, uint64_t seed);
+    void receive();
+    void handleInputs(const uint8_t* p, size_t size);
+    void sendInputs();
+    void sendControl(uint8_t type);
+    void rollback();
+    void confirm();
+    void compareChecksums();
+    void stepFrame(int64_t f);
+
+    UdpSocket   socket;
+    NetAddress  peer;
+    NetStatus   state = NetIdle;
+    int         side = 0;
+    ArenaConfig arenaConfig;
+    uint64_t    seed = 0;
+
+    ArenaSim              current;
+    std::vector<ArenaSim> snapshots;        // [f % size] = arena before tick f
+    std::vector<Direction> tickInputs;      // scratch for ArenaSim::step
+
+    int64_t   frameCount = 0;               // ticks simulated
+    Direction localTurns[INPUT_RING];       // by tick
+    int64_t   localEnd = 0;                 // ticks with a local turn
+    Direction remoteTurns[INPUT_RING];      // by tick, as received
+    Direction remoteUsed[INPUT_RING];       // by tick, what the sim was given
+    int64_t   remoteEnd = 0;                // ticks with a received turn
+    int64_t   peerAck = 0;                  // ticks of ours the peer has
+    int64_t   rollbackFrom = -1;            // earliest misprediction, or -1
+
+    int64_t   peerFrame = 0;                // peer's tick count, as last heard
+    int       peerAdvantage = 0;            // how far it thought it was ahead
+    int64_t   lastSkip = 0;
+
+    int64_t   checkFrames[CHECK_RING];      // confirmed tick -> checksum, every CHECK_INTERVAL
+    uint64_t  checkSums[CHECK_RING];
+    int64_t   checkedUpTo = 0;
+    int64_t   peerCheckFrame = -1;          // the peer's latest checksum
+    uint64_t  peerCheckSum = 0;
+    bool      desync = false;
+
+    int64_t   lastHeardUs = 0;
+    int64_t   lastSentUs = 0;
+
+    uint64_t  rollbackCount = 0;
+    uint64_t  resimulated = 0;
+    int       deepest = 0;
+    uint64_t  waitCount = 0;
+    uint64_t  skipCount = 0;
+};
@@ -0,0 +1,122 @@
+﻿#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+const char* zoneName(ProfileZone zone) {
+    static const char* names[ZONE_COUNT] = {
+        "events", "sim", "audio", "background", "entities", "hud", "capture", "display"
+    };
+    return zone < ZONE_COUNT ? names[zone] : "frame";
+}
+
+double processCpuSeconds() {
+#if defined(_WIN32)
+    // MSVC's std::clock() is wall time, so ask for kernel + user time
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& f) {
+        return (uint64_t(f.dwHighDateTime) << 32) | f.dwLowDateTime;
+    };
+    return double(ticks(kernel) + ticks(user)) * 100e-9;    // 100 ns units
+#else
+    return double(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+static int64_t steadyNs() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::Profiler()
+    : epochNs(steadyNs())
+{
+}
+
+int64_t Profiler::now() const {
+    return steadyNs() - epochNs;
+}
+
+void Profiler::beginFrame() {
+    frameStartNs = now();
+    frameZoneNs.fill(0);
+}
+
+void Profiler::record(ProfileZone zone, int64_t startNs, int64_t endNs) {
+    frameZoneNs[zone] += endNs - startNs;
+    if (capturing) {
+        if (trace.size() < MAX_TRACE_EVENTS) trace.push_back({ startNs, endNs - startNs, int32_t(zone) });
+        else capturing = false;
+    }
+}
+
+void Profiler::endFrame() {
+    if (frameStartNs < 0) return;
+    int64_t endNs = now();
+    frameMs[historyNext] = float(endNs - frameStartNs) / 1e6f;
+    for (int z = 0; z < ZONE_COUNT; ++z) zoneMs[historyNext][z] = float(frameZoneNs[z]) / 1e6f;
+    historyNext = (historyNext + 1) % HISTORY;
+    historyCount = std::min(historyCount + 1, HISTORY);
+
+    if (capturing) {
+        if (trace.size() < MAX_TRACE_EVENTS) {
+            trace.push_back({ frameStartNs, endNs - frameStartNs, int32_t(ZONE_COUNT) });
+        }
+        else {
+            capturing = false;
+        }
+    }
+}
+
+void Profiler::summarize() {
+    if (historyCount == 0) return;
+
+    std::array<float, HISTORY> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.begin() + historyCount);
+    auto pick = [&](float p) { return sorted[std::min(historyCount - 1, size_t(p * historyCount))]; };
+    p50FrameMs = pick(0.50f);
+    p95FrameMs = pick(0.95f);
+    p99FrameMs = pick(0.99f);
+    maxFrameMs = sorted[historyCount - 1];
+
+    avgZoneMs.fill(0.f);
+    for (size_t i = 0; i < historyCount; ++i) {
+        for (int z = 0; z < ZONE_COUNT; ++z) avgZoneMs[z] += zoneMs[i][z];
+    }
+    for (float& ms : avgZoneMs) ms /= float(historyCount);
+}
+
+void Profiler::startCapture() {
+    trace.clear();
+    trace.reserve(MAX_TRACE_EVENTS);
+    capturing = true;
+}
+
+// Complete ("X") events on one thread; frames wrap their zones so the
+// viewer nests them
+bool Profiler::writeTrace(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+                    "\"args\":{\"name\":\"main loop\"}}");
+    for (const TraceEvent& e : trace) {
+        std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                        "\"ts\":%.3f,\"dur\":%.3f}",
+                     zoneName(ProfileZone(e.zone)), e.zone == ZONE_COUNT ? "frame" : "zone",
+                     double(e.startNs) / 1000.0, double(e.durationNs) / 1000.0);
+    }
+    std::fprintf(f, "\n]}\n");
+    bool ok = std::ferror(f) == 0;
+    return std::fclose(f) == 0 && ok;
+}
@@ -0,0 +1,109 @@
+﻿#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Frame profiler
+//
+// The main loop is split into a fixed set of zones, each timed with a
+// ProfileScope. The profiler keeps per-zone totals for the current frame, a
+// short history of frame times for percentiles, and (while a capture is
+// running) every scope as a Chrome trace event. Open the written JSON in
+// chrome://tracing or https://ui.perfetto.dev.
+//
+// Timing a scope is two steady_clock reads; nothing allocates outside
+// startCapture() and writeTrace().
+// ─────────────────────────────────────────────────────────────────────────────
+
+enum ProfileZone {
+    ZoneEvents,         // pollEvent loop
+    ZoneSim,            // fixed-timestep ticks
+    ZoneAudio,          // starting the sounds the ticks asked for
+    ZoneBackground,     // checkerboard + border
+    ZoneEntities,       // building and drawing the entity batch
+    ZoneHud,            // text and menus
+    ZoneCapture,        // reading back and queueing a video frame (--video only)
+    ZoneDisplay,        // window.display() (includes vsync / frame limiter waits)
+    ZONE_COUNT
+};
+
+const char* zoneName(ProfileZone zone);
+
+// CPU time used so far by the whole process (every thread), in seconds
+double processCpuSeconds();
+
+class Profiler {
+public:
+    static constexpr size_t HISTORY = 256;              // frames kept for percentiles
+    static constexpr size_t MAX_TRACE_EVENTS = 1 << 18; // capture stops when full
+
+    Profiler();
+
+    void beginFrame();
+    void endFrame();
+
+    // Called by ProfileScope
+    int64_t now() const;
+    void    record(ProfileZone zone, int64_t startNs, int64_t endNs);
+
+    // Records [sinceNs, now) into `zone` and returns now, so consecutive
+    // sections of one block can be timed without nesting scopes
+    int64_t lap(ProfileZone zone, int64_t sinceNs) {
+        int64_t t = now();
+        record(zone, sinceNs, t);
+        return t;
+    }
+
+    // Recompute the summary below from the history (cheap; call once a second)
+    void summarize();
+
+    float p50FrameMs = 0.f;
+    float p95FrameMs = 0.f;
+    float p99FrameMs = 0.f;
+    float maxFrameMs = 0.f;
+    std::array<float, ZONE_COUNT> avgZoneMs{};      // average over the history
+
+    // Chrome trace capture
+    void   startCapture();
+    void   stopCapture() { capturing = false; }
+    bool   isCapturing() const { return capturing; }
+    size_t capturedEvents() const { return trace.size(); }
+    bool   writeTrace(const std::string& path) const;
+
+private:
+    struct TraceEvent {
+        int64_t startNs;
+        int64_t durationNs;
+        int32_t zone;                               // ZONE_COUNT marks a whole frame
+    };
+
+    int64_t epochNs;
+    int64_t frameStartNs = -1;                      // -1 until the first beginFrame()
+    std::array<int64_t, ZONE_COUNT> frameZoneNs{};
+
+    std::array<float, HISTORY> frameMs{};
+    std::array<std::array<float, ZONE_COUNT>, HISTORY> zoneMs{};
+    size_t historyCount = 0;
+    size_t historyNext = 0;
+
+    bool capturing = false;
+    std::vector<TraceEvent> trace;
+};
+
+// Times the enclosing block into `zone`
+class ProfileScope {
+public:
+    ProfileScope(Profiler& p, ProfileZone z) : profiler(p), zone(z), start(p.now()) {}
+    ~ProfileScope() { profiler.record(zone, start, profiler.now()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler&   profiler;
+    ProfileZone zone;
+    int64_t     start;
+};
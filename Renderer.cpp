@@ -0,0 +1,159 @@
+﻿#include "Renderer.h"
+#include "AllocCounter.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Writes two triangles at va[v..v+5]
+static void appendQuad(sf::VertexArray& va, size_t& v,
+                       sf::Vector2f pos, sf::Vector2f size, sf::Color color,
+                       sf::Vector2f texPos = {}, sf::Vector2f texSize = {})
+{
+    const sf::Vector2f corner[4] = {
+        { 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f }
+    };
+    const int order[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int i : order) {
+        sf::Vertex& vx = va[v++];
+        vx.position = { pos.x + size.x * corner[i].x, pos.y + size.y * corner[i].y };
+        vx.texCoords = { texPos.x + texSize.x * corner[i].x, texPos.y + texSize.y * corner[i].y };
+        vx.color = color;
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// BoardBackground
+// ─────────────────────────────────────────────────────────────────────────────
+
+sf::View boardCamera(sf::Vector2f focus, sf::Vector2f viewSize, sf::Vector2f boardSize) {
+    auto axis = [](float f, float view, float board) {
+        if (board <= view) return board / 2.f;
+        return std::clamp(f, view / 2.f, board - view / 2.f);
+    };
+    return sf::View({ axis(focus.x, viewSize.x, boardSize.x), axis(focus.y, viewSize.y, boardSize.y) },
+                    viewSize);
+}
+
+CellRange visibleCells(const sf::View& view, unsigned columns, unsigned rows, float blockSize) {
+    sf::Vector2f topLeft = view.getCenter() - view.getSize() / 2.f;
+    sf::Vector2f bottomRight = view.getCenter() + view.getSize() / 2.f;
+    CellRange r;
+    r.x0 = std::max(0, int(std::floor(topLeft.x / blockSize)));
+    r.y0 = std::max(0, int(std::floor(topLeft.y / blockSize)));
+    r.x1 = std::min(int(columns), int(std::ceil(bottomRight.x / blockSize)));
+    r.y1 = std::min(int(rows), int(std::ceil(bottomRight.y / blockSize)));
+    return r;
+}
+
+void BoardBackground::update(unsigned columns, unsigned rows, float blockSize,
+                             const CellRange& visible)
+{
+    if (columns == cols && rows == rowCount && blockSize == block && visible == range) return;
+    cols = columns;
+    rowCount = rows;
+    block = blockSize;
+    range = visible;
+
+    // One quad per cell; border cells take the wall color directly. The
+    // vertex storage only grows, so panning doesn't allocate.
+    const int w = std::max(0, visible.x1 - visible.x0);
+    const int h = std::max(0, visible.y1 - visible.y0);
+    vertices.resize(size_t(w) * size_t(h) * 6);
+    size_t v = 0;
+    for (int r = visible.y0; r < visible.y0 + h; ++r) {
+        for (int c = visible.x0; c < visible.x0 + w; ++c) {
+            bool border = r == 0 || c == 0 || r == int(rows) - 1 || c == int(columns) - 1;
+            sf::Color color = border ? BORDER_COLOR
+                            : ((r + c) % 2 == 0) ? BG_COLOR1 : BG_COLOR2;
+            appendQuad(vertices, v, { c * blockSize, r * blockSize },
+                       { blockSize, blockSize }, color);
+        }
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// EntityBatch
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Atlas layout: a white anti-aliased disc in the left 32x32 tile and a solid
+// white tile on the right (sampled away from its edges to avoid bleeding).
+static const unsigned ATLAS_TILE = 32;
+static const sf::Vector2f DISC_POS{ 0.f, 0.f };
+static const sf::Vector2f DISC_SIZE{ float(ATLAS_TILE), float(ATLAS_TILE) };
+static const sf::Vector2f SOLID_POS{ ATLAS_TILE + 8.f, 8.f };
+static const sf::Vector2f SOLID_SIZE{ 16.f, 16.f };
+
+bool EntityBatch::init() {
+    sf::Image image({ ATLAS_TILE * 2, ATLAS_TILE }, sf::Color::Transparent);
+
+    const float r = ATLAS_TILE / 2.f;
+    for (unsigned y = 0; y < ATLAS_TILE; ++y) {
+        for (unsigned x = 0; x < ATLAS_TILE; ++x) {
+            float dx = x + 0.5f - r;
+            float dy = y + 0.5f - r;
+            float coverage = std::clamp(r - std::sqrt(dx * dx + dy * dy), 0.f, 1.f);
+            image.setPixel({ x, y }, sf::Color(255, 255, 255, std::uint8_t(coverage * 255.f)));
+            image.setPixel({ x + ATLAS_TILE, y }, sf::Color::White);
+        }
+    }
+
+    if (!atlas.loadFromImage(image)) return false;
+    atlas.setSmooth(true);
+    return true;
+}
+
+void EntityBatch::addQuad(sf::Vector2f position, sf::Vector2f size,
+                          sf::Vector2f texPos, sf::Vector2f texSize, sf::Color color)
+{
+    if (used + 6 > vertices.getVertexCount()) {
+        // Grow geometrically; only happens until the longest snake seen so far
+        vertices.resize(std::max<size_t>(64 * 6, vertices.getVertexCount() * 2));
+    }
+    appendQuad(vertices, used, position, size, color, texPos, texSize);
+}
+
+void EntityBatch::addCircle(sf::Vector2f center, float radius, sf::Color color) {
+    addQuad({ center.x - radius, center.y - radius }, { radius * 2.f, radius * 2.f },
+            DISC_POS, DISC_SIZE, color);
+}
+
+void EntityBatch::addRect(sf::Vector2f position, sf::Vector2f size, sf::Color color) {
+    addQuad(position, size, SOLID_POS, SOLID_SIZE, color);
+}
+
+void EntityBatch::draw(sf::RenderTarget& target) const {
+    if (used == 0) return;
+    sf::RenderStates states;
+    states.texture = &atlas;
+    target.draw(&vertices[0], used, sf::PrimitiveType::Triangles, states);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// FrameStats
+// ─────────────────────────────────────────────────────────────────────────────
+
+void FrameStats::beginFrame() {
+    drawCalls = 0;
+    allocsAtBegin = allocationCount();
+}
+
+bool FrameStats::endFrame(float frameSeconds) {
+    accumAllocs += allocationCount() - allocsAtBegin;
+    accumSeconds += frameSeconds;
+    accumMax = std::max(accumMax, frameSeconds);
+    accumDraws += drawCalls;
+    ++frames;
+
+    if (accumSeconds < 1.f) return false;
+
+    avgFrameMs = accumSeconds * 1000.f / frames;
+    maxFrameMs = accumMax * 1000.f;
+    avgDrawCalls = unsigned(accumDraws / frames);
+    avgAllocs = float(accumAllocs) / frames;
+    accumSeconds = 0.f;
+    accumMax = 0.f;
+    accumDraws = 0;
+    accumAllocs = 0;
+    frames = 0;
+    return true;
+}
@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <cstdint>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Rendering helpers for the Playing screen
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Colors
+const sf::Color BG_COLOR1 = sf::Color(34, 139, 34); // ForestGreen
+const sf::Color BG_COLOR2 = sf::Color(46, 160, 46); // lighter
+const sf::Color OBSTACLE_COLOR = sf::Color::Red;           // bright red
+const sf::Color BONUS_COLOR = sf::Color::Yellow;
+const sf::Color BORDER_COLOR = sf::Color(105, 105, 105); // DimGray
+
+// Arena bots, by agent id
+const int       ARENA_BOT_COLOR_COUNT = 6;
+const sf::Color ARENA_BOT_COLORS[ARENA_BOT_COLOR_COUNT] = {
+    sf::Color(30, 144, 255), sf::Color(255, 140, 0), sf::Color(0, 206, 209),
+    sf::Color(220, 20, 60), sf::Color(154, 205, 50), sf::Color(139, 69, 19),
+};
+
+// Board cells [x0, x1) x [y0, y1)
+struct CellRange {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    bool contains(int x, int y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+    bool operator==(const CellRange& o) const {
+        return x0 == o.x0 && y0 == o.y0 && x1 == o.x1 && y1 == o.y1;
+    }
+};
+
+// Camera for boards bigger than the window: centred on `focus` but kept
+// inside the board. Along an axis where the board is smaller than the view
+// the board is centred instead.
+sf::View boardCamera(sf::Vector2f focus, sf::Vector2f viewSize, sf::Vector2f boardSize);
+
+// Cells of a columns x rows board (blockSize pixels each) that `view` shows
+CellRange visibleCells(const sf::View& view, unsigned columns, unsigned rows, float blockSize);
+
+// Static board background (checkerboard + border wall) baked into a single
+// vertex array, so it costs one draw call instead of one per cell. Only the
+// cells the camera can see are baked, so the cost follows the window size,
+// not the board size.
+class BoardBackground {
+public:
+    // Rebuilds the vertices only when the grid, cell size or visible range changed
+    void update(unsigned columns, unsigned rows, float blockSize, const CellRange& visible);
+    void draw(sf::RenderTarget& target) const { target.draw(vertices); }
+
+private:
+    sf::VertexArray vertices{ sf::PrimitiveType::Triangles };
+    unsigned  cols = 0;
+    unsigned  rowCount = 0;
+    float     block = 0.f;
+    CellRange range;
+};
+
+// Batches every dynamic entity (snake, food, bonus, obstacles) into one
+// reusable vertex array. Circles and squares are textured quads cut from a
+// small generated atlas and tinted through the vertex color, so the whole
+// set is submitted in a single draw call no matter how long the snake is.
+class EntityBatch {
+public:
+    // Builds the atlas texture; returns false if the texture can't be created
+    bool init();
+
+    void clear() { used = 0; }
+    void addCircle(sf::Vector2f center, float radius, sf::Color color);
+    void addRect(sf::Vector2f position, sf::Vector2f size, sf::Color color);
+    void draw(sf::RenderTarget& target) const;
+
+    size_t quadCount() const { return used / 6; }
+
+private:
+    void addQuad(sf::Vector2f position, sf::Vector2f size,
+                 sf::Vector2f texPos, sf::Vector2f texSize, sf::Color color);
+
+    sf::Texture     atlas;
+    sf::VertexArray vertices{ sf::PrimitiveType::Triangles };
+    size_t          used = 0;     // vertices filled this frame; storage is kept between frames
+};
+
+// Draw-call, allocation and frame-time counters, summarised once per second
+struct FrameStats {
+    unsigned drawCalls = 0;        // draws issued so far this frame
+
+    // Last one-second summary
+    float    avgFrameMs = 0.f;
+    float    maxFrameMs = 0.f;
+    unsigned avgDrawCalls = 0;
+    float    avgAllocs = 0.f;      // heap allocations per frame (see AllocCounter.h)
+
+    void beginFrame();
+
+    // Returns true when a new summary is available
+    bool endFrame(float frameSeconds);
+
+private:
+    float    accumSeconds = 0.f;
+    float    accumMax = 0.f;
+    unsigned frames = 0;
+    unsigned long long accumDraws = 0;
+    uint64_t allocsAtBegin = 0;
+    uint64_t accumAllocs = 0;
+};
@@ -0,0 +1,153 @@
+﻿#include "Replay.h"
+#include "Util.h"
+
+#include <fstream>
+#include <iterator>
+
+static const unsigned RESTORE_CODE = 5;
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// ReplayWriter
+// ─────────────────────────────────────────────────────────────────────────────
+
+void ReplayWriter::begin(uint64_t seed, int startingLevel, int columns, int rows) {
+    bytes.clear();
+    bytes.reserve(4096);
+    for (char c : { 'S', 'N', 'K', 'R' }) bytes.push_back(uint8_t(c));
+    bytes.push_back(REPLAY_VERSION);
+    bytes.push_back(uint8_t(startingLevel));
+    putLe(bytes, seed, 8);
+    putLe(bytes, uint64_t(columns), 2);
+    putLe(bytes, uint64_t(rows), 2);
+    tick = 0;
+    lastEventTick = 0;
+    recording = true;
+}
+
+void ReplayWriter::record(Direction input) {
+    if (!recording) return;
+    ++tick;
+    if (input == None) return;
+    putVarint(bytes, ((tick - lastEventTick) << 3) | uint64_t(input));
+    lastEventTick = tick;
+}
+
+void ReplayWriter::recordRestore(uint64_t simTick) {
+    if (!recording) return;
+    putVarint(bytes, ((tick - lastEventTick) << 3) | RESTORE_CODE);
+    putVarint(bytes, simTick);
+    lastEventTick = tick;
+}
+
+void ReplayWriter::finish(int finalScore) {
+    if (!recording) return;
+    putVarint(bytes, (tick - lastEventTick) << 3);
+    putVarint(bytes, uint64_t(finalScore < 0 ? 0 : finalScore));
+    recording = false;
+}
+
+bool ReplayWriter::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+    return bool(out);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// ReplayReader
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool ReplayReader::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    return parse(std::move(data));
+}
+
+bool ReplayReader::readVarint(size_t& at, uint64_t& out) const {
+    out = 0;
+    for (int shift = 0; shift < 64 && at < bytes.size(); shift += 7) {
+        uint8_t b = bytes[at++];
+        out |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool ReplayReader::parse(std::vector<uint8_t> data) {
+    bytes = std::move(data);
+    const size_t headerSize = 4 + 1 + 1 + 8 + 2 + 2;
+    if (bytes.size() < headerSize ||
+        bytes[0] != 'S' || bytes[1] != 'N' || bytes[2] != 'K' || bytes[3] != 'R' ||
+        bytes[4] < REPLAY_OLDEST_VERSION || bytes[4] > REPLAY_VERSION)
+    {
+        return false;
+    }
+    level = bytes[5];
+    seed_ = readLe(&bytes[6], 8);
+    cols = int(readLe(&bytes[14], 2));
+    rowCount = int(readLe(&bytes[16], 2));
+    if (cols < MIN_BOARD_SIDE || cols > MAX_BOARD_SIDE ||
+        rowCount < MIN_BOARD_SIDE || rowCount > MAX_BOARD_SIDE)
+    {
+        return false;
+    }
+    bodyStart = headerSize;
+
+    // Walk the events once to validate them and find the end record
+    size_t at = bodyStart;
+    uint64_t t = 0, v = 0;
+    for (;;) {
+        if (!readVarint(at, v)) return false;
+        t += v >> 3;
+        if ((v & 7) == 0) break;
+        if ((v & 7) == RESTORE_CODE && readVarint(at, v)) continue;
+        if ((v & 7) > Right) return false;
+    }
+    if (!readVarint(at, v)) return false;
+    endTick = t;
+    score = int(v);
+
+    rewind();
+    return true;
+}
+
+void ReplayReader::rewind() {
+    cursor = bodyStart;
+    tick = 0;
+    eventTick = 0;
+    readEvent();
+}
+
+void ReplayReader::readEvent() {
+    uint64_t v = 0;
+    readVarint(cursor, v);        // validated in parse()
+    eventTick += v >> 3;
+    eventCode = unsigned(v & 7);
+    if (eventCode == RESTORE_CODE) readVarint(cursor, restoreTick);
+}
+
+bool ReplayReader::restorePending(uint64_t& simTick) {
+    if (eventTick != tick || eventCode != RESTORE_CODE) return false;
+    simTick = restoreTick;
+    readEvent();
+    return true;
+}
+
+Direction ReplayReader::next() {
+    if (finished()) return None;
+    ++tick;
+    if (tick != eventTick || eventCode == 0 || eventCode == RESTORE_CODE) return None;
+    Direction d = Direction(eventCode);
+    readEvent();
+    return d;
+}
@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Deterministic replays
+//
+// A SnakeSim run is fully determined by its seed, starting level, board
+// size and the input passed to each step(), so that is all a replay stores:
+//
+//   "SNKR"  u8 version  u8 startingLevel  u64 seed  u16 columns  u16 rows
+//           (little endian)
+//   events  varint((ticksSincePreviousEvent << 3) | direction), direction 1..4
+//   restore varint((ticksSincePreviousEvent << 3) | 5)  varint(simTick)
+//   end     varint((ticksSincePreviousEvent << 3) | 0)  varint(finalScore)
+//
+// Ticks with no turn cost nothing, so a whole game is typically a few
+// hundred bytes. A restore (rewind or level restart, see Rewind.h) comes
+// between two ticks and names the sim tick the game went back to.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Bumped whenever the sim changes in a way that alters games for the same
+// seed and inputs (version 2: food only spawns where the head can reach;
+// version 3: board size in the header, obstacle count scales with it;
+// version 4: obstacles come from the level generator; version 5: restore
+// events, otherwise the same as 4, which is still read)
+const uint8_t REPLAY_VERSION = 5;
+const uint8_t REPLAY_OLDEST_VERSION = 4;
+
+class ReplayWriter {
+public:
+    void begin(uint64_t seed, int startingLevel, int columns, int rows);
+
+    // Call once per sim tick with the input that was passed to step()
+    void record(Direction input);
+    // Call after the game went back to sim tick `simTick`
+    void recordRestore(uint64_t simTick);
+
+    // Closes the stream; `finalScore` lets playback verify the re-simulation
+    void finish(int finalScore);
+    bool save(const std::string& path) const;
+
+    bool active() const { return recording; }
+    const std::vector<uint8_t>& data() const { return bytes; }
+
+private:
+    std::vector<uint8_t> bytes;
+    uint64_t tick = 0;
+    uint64_t lastEventTick = 0;
+    bool     recording = false;
+};
+
+class ReplayReader {
+public:
+    bool load(const std::string& path);
+    bool parse(std::vector<uint8_t> data);
+
+    uint64_t seed() const { return seed_; }
+    int      startingLevel() const { return level; }
+    int      columns() const { return cols; }
+    int      rows() const { return rowCount; }
+    int      finalScore() const { return score; }
+    uint64_t totalTicks() const { return endTick; }
+
+    // Restart playback from tick 0
+    void rewind();
+
+    // A restore recorded after the tick just played: true (once per
+    // restore) with the sim tick to go back to. Drain it after every step()
+    // and once before the first, before looking at finished().
+    bool      restorePending(uint64_t& simTick);
+
+    // Input for the next tick; call once per step()
+    Direction next();
+    bool      finished() const { return tick >= endTick; }
+
+private:
+    bool readVarint(size_t& at, uint64_t& out) const;
+    void readEvent();
+
+    std::vector<uint8_t> bytes;
+    size_t    bodyStart = 0;
+    size_t    cursor = 0;
+    uint64_t  seed_ = 0;
+    int       level = 1;
+    int       cols = DEFAULT_COLUMNS;
+    int       rowCount = DEFAULT_ROWS;
+    int       score = 0;
+    uint64_t  endTick = 0;
+
+    uint64_t  tick = 0;
+    uint64_t  eventTick = 0;       // tick of the pending event
+    unsigned  eventCode = 0;       // a Direction, 0 for the end record, 5 for a restore
+    uint64_t  restoreTick = 0;     // sim tick of a pending restore
+};
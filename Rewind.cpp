@@ -0,0 +1,74 @@
+﻿#include "Rewind.h"
+
+#include <algorithm>
+
+RewindBuffer::RewindBuffer(size_t ticks)
+    : ring(std::max<size_t>(ticks, 2))
+    , checkpoints(CHECKPOINTS)
+{
+}
+
+void RewindBuffer::begin(const SnakeSim& sim) {
+    count = 0;
+    checkpointCount = 0;
+    push(sim);
+    pushCheckpoint(sim);
+}
+
+void RewindBuffer::afterStep(const SnakeSim& sim, unsigned events) {
+    push(sim);
+    if (events & EvLevelUp) pushCheckpoint(sim);
+}
+
+void RewindBuffer::push(const SnakeSim& sim) {
+    newest = count == 0 ? 0 : (newest + 1) % ring.size();
+    count = std::min(count + 1, ring.size());
+    sim.save(ring[newest]);
+}
+
+void RewindBuffer::pushCheckpoint(const SnakeSim& sim) {
+    checkpointNewest = checkpointCount == 0 ? 0 : (checkpointNewest + 1) % checkpoints.size();
+    checkpointCount = std::min(checkpointCount + 1, checkpoints.size());
+    sim.save(checkpoints[checkpointNewest]);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Going back
+// ─────────────────────────────────────────────────────────────────────────────
+
+bool RewindBuffer::restoreFrom(SnakeSim& sim, const SimSnapshot& snap) {
+    if (!sim.restore(snap)) return false;
+    const uint64_t tick = sim.tick();
+
+    // Everything newer belongs to the abandoned future
+    while (count > 0 && slot(0).ticks > tick) {
+        newest = (newest + ring.size() - 1) % ring.size();
+        --count;
+    }
+    while (checkpointCount > 0 && checkpoints[checkpointNewest].ticks > tick) {
+        checkpointNewest = (checkpointNewest + checkpoints.size() - 1) % checkpoints.size();
+        --checkpointCount;
+    }
+    // A checkpoint older than every tick in the ring becomes its present
+    if (count == 0 || slot(0).ticks != tick) push(sim);
+    return true;
+}
+
+bool RewindBuffer::rewind(SnakeSim& sim, size_t ticks) {
+    return count > 1 && ticks > 0 && restoreFrom(sim, slot(std::min(ticks, count - 1)));
+}
+
+bool RewindBuffer::restartLevel(SnakeSim& sim) {
+    return checkpointCount > 0 && restoreFrom(sim, checkpoints[checkpointNewest]);
+}
+
+bool RewindBuffer::restore(SnakeSim& sim, uint64_t tick) {
+    for (size_t back = 0; back < count; ++back) {
+        if (slot(back).ticks == tick) return restoreFrom(sim, slot(back));
+    }
+    for (size_t back = 0; back < checkpointCount; ++back) {
+        const SimSnapshot& snap = checkpoints[(checkpointNewest + checkpoints.size() - back) % checkpoints.size()];
+        if (snap.ticks == tick) return restoreFrom(sim, snap);
+    }
+    return false;
+}
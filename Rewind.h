@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include "SnakeSim.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Rewind and level checkpoints
+//
+// A snapshot of every tick of the last few seconds (a ring of SimSnapshots,
+// overwritten oldest first) plus one per level start, so a game can be taken
+// back a few seconds or to the start of the level. Going back forgets every
+// snapshot after the tick it went to, as that future is not going to happen.
+//
+// The game and the replay player keep the buffer the same way (begin(), then
+// afterStep() on every tick), so a replay can name a restore by its sim tick
+// and find the same snapshot.
+// ─────────────────────────────────────────────────────────────────────────────
+
+class RewindBuffer {
+public:
+    static const size_t DEFAULT_TICKS = 64;     // a few seconds at any level's speed
+    static const size_t CHECKPOINTS = 8;        // level starts kept, newest first
+
+    explicit RewindBuffer(size_t ticks = DEFAULT_TICKS);
+
+    // A new game: forgets everything and checkpoints the start
+    void begin(const SnakeSim& sim);
+    // Call after every step() with its events; a level-up is checkpointed
+    void afterStep(const SnakeSim& sim, unsigned events);
+
+    // Ticks that can be gone back (not counting the present)
+    size_t ticksKept() const { return count > 0 ? count - 1 : 0; }
+
+    // Back `ticks` ticks, or as far as the buffer reaches; false if it kept
+    // nothing to go back to. sim.tick() is then what a replay records.
+    bool rewind(SnakeSim& sim, size_t ticks);
+    // Back to the start of the current level
+    bool restartLevel(SnakeSim& sim);
+    // Back to the kept snapshot of sim tick `tick`; false if there is none
+    bool restore(SnakeSim& sim, uint64_t tick);
+
+private:
+    const SimSnapshot& slot(size_t back) const { return ring[(newest + ring.size() - back) % ring.size()]; }
+    void push(const SnakeSim& sim);
+    void pushCheckpoint(const SnakeSim& sim);
+    bool restoreFrom(SnakeSim& sim, const SimSnapshot& snap);
+
+    std::vector<SimSnapshot> ring;
+    size_t newest = 0;                  // slot of the latest tick
+    size_t count = 0;                   // slots in use
+    std::vector<SimSnapshot> checkpoints;
+    size_t checkpointNewest = 0;
+    size_t checkpointCount = 0;
+};
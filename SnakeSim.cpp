@@ -0,0 +1,604 @@
+﻿#include "SnakeSim.h"
+#include "LevelGen.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+Direction opposite(Direction d) {
+    switch (d) {
+    case Up:    return Down;
+    case Down:  return Up;
+    case Left:  return Right;
+    case Right: return Left;
+    default:    return None;
+    }
+}
+
+Cell advance(Cell c, Direction d) {
+    switch (d) {
+    case Up:    c.y -= 1; break;
+    case Down:  c.y += 1; break;
+    case Left:  c.x -= 1; break;
+    case Right: c.x += 1; break;
+    default:    break;
+    }
+    return c;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Bitboard
+// ─────────────────────────────────────────────────────────────────────────────
+
+static int popcount64(uint64_t w) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return int(__popcnt64(w));
+#elif defined(__GNUC__)
+    return __builtin_popcountll(w);
+#else
+    int n = 0;
+    for (; w; w &= w - 1) ++n;
+    return n;
+#endif
+}
+
+void Bitboard::resize(int columns, int rows) {
+    cols = columns;
+    rowCount = rows;
+    stride_ = (size_t(columns) + 63) / 64;
+    lastMask = columns % 64 ? (uint64_t(1) << (columns % 64)) - 1 : ~uint64_t(0);
+    words.assign((size_t(rows) + 2) * stride_, 0);
+}
+
+void Bitboard::clear() {
+    std::fill(words.begin(), words.end(), uint64_t(0));
+}
+
+int Bitboard::count() const {
+    int n = 0;
+    for (uint64_t w : words) n += popcount64(w);
+    return n;
+}
+
+bool Bitboard::operator==(const Bitboard& o) const {
+    return cols == o.cols && rowCount == o.rowCount && words == o.words;
+}
+
+Bitboard Bitboard::complement() const {
+    Bitboard out(cols, rowCount);
+    for (size_t i = stride_; i < words.size() - stride_; ++i) {
+        out.words[i] = ~words[i] & wordMask(i % stride_);
+    }
+    return out;
+}
+
+Bitboard Bitboard::shifted(Direction d) const {
+    Bitboard out(cols, rowCount);
+    const size_t S = stride_;
+    for (size_t i = S; i < words.size() - S; ++i) {
+        size_t w = i % S;
+        uint64_t v;
+        switch (d) {
+        case Up:    v = words[i + S]; break;
+        case Down:  v = words[i - S]; break;
+        case Left:  v = (words[i] >> 1) | (w + 1 < S ? words[i + 1] << 63 : 0); break;
+        case Right: v = (words[i] << 1) | (w > 0 ? words[i - 1] >> 63 : 0);     break;
+        default:    v = words[i];     break;
+        }
+        out.words[i] = v & wordMask(w);
+    }
+    return out;
+}
+
+// All set bits of `m` that share a run of consecutive set bits with a bit of
+// `seeds` (seeds must be a subset of m). Upward: adding the seeds makes a
+// carry ripple through each seeded run, and the carries are exactly the
+// run bits above a seed. Downward: Kogge-Stone, six shift steps.
+static uint64_t fillRuns(uint64_t seeds, uint64_t m) {
+    uint64_t g = (((m + seeds) ^ m ^ seeds) & m) | seeds;
+    uint64_t p = m;
+    g |= p & (g >> 1);  p &= p >> 1;
+    g |= p & (g >> 2);  p &= p >> 2;
+    g |= p & (g >> 4);  p &= p >> 4;
+    g |= p & (g >> 8);  p &= p >> 8;
+    g |= p & (g >> 16); p &= p >> 16;
+    g |= p & (g >> 32);
+    return g;
+}
+
+// Alternating top-down and bottom-up sweeps. Each row takes in the row
+// before it and is then filled along its open runs in one go, so a sweep
+// carries the region as far as it can go in that vertical direction and
+// only paths that double back need another sweep (usually two or three).
+// Boards up to 64 columns (the default one included) take a one-word-per-row
+// loop; on wider rows a run can cross word boundaries, and one pass up and
+// one pass down the row's words carry it across.
+void Bitboard::floodFill(const Bitboard& blocked, const Cell& from, Bitboard& out) {
+    out.resize(blocked.cols, blocked.rowCount);
+    out.set(from);
+    // The sizes the game offers in its docs and benchmarks: 40x30 (1 word
+    // per row), 100x80 (2), 200x150 (4), 300x200 (5), 512x512 (8) and
+    // 1000x1000 (16), plus 3. Each is one more copy of fillRows().
+    switch (blocked.stride_) {
+    case 1:  fillNarrow(blocked, from, out);   break;
+    case 2:  fillRows<2>(blocked, from, out);  break;
+    case 3:  fillRows<3>(blocked, from, out);  break;
+    case 4:  fillRows<4>(blocked, from, out);  break;
+    case 5:  fillRows<5>(blocked, from, out);  break;
+    case 8:  fillRows<8>(blocked, from, out);  break;
+    case 16: fillRows<16>(blocked, from, out); break;
+    default: fillRows<0>(blocked, from, out);  break;
+    }
+}
+
+void Bitboard::floodFillGeneric(const Bitboard& blocked, const Cell& from, Bitboard& out) {
+    out.resize(blocked.cols, blocked.rowCount);
+    out.set(from);
+    fillRows<0>(blocked, from, out);
+}
+
+void Bitboard::fillNarrow(const Bitboard& blocked, const Cell& from, Bitboard& out) {
+    const size_t rows = size_t(blocked.rowCount);
+    const uint64_t* b = blocked.words.data();
+    uint64_t* cur = out.words.data();
+    const uint64_t mask = blocked.lastMask;
+    auto grow = [&](size_t y, size_t neighbour) {
+        uint64_t m = (~b[y] & mask) | cur[y];
+        uint64_t seeds = (cur[y] | cur[neighbour]) & m;
+        if (seeds == cur[y]) return uint64_t(0);
+        uint64_t filled = fillRuns(seeds, m);
+        uint64_t changed = filled ^ cur[y];
+        cur[y] = filled;
+        return changed;
+    };
+    const size_t y0 = size_t(from.y) + 1;
+    cur[y0] = fillRuns(cur[y0], (~b[y0] & mask) | cur[y0]);
+    for (;;) {
+        uint64_t changed = 0;
+        for (size_t y = 1; y <= rows; ++y) changed |= grow(y, y - 1);
+        for (size_t y = rows; y >= 1; --y) changed |= grow(y, y + 1);
+        if (changed == 0) break;
+    }
+}
+
+// Rows of several words. With FixedStride set, the words per row is a
+// compile-time constant: the loops over a row have a fixed trip count and
+// unroll, and row offsets are constant multiplies. FixedStride 0 reads it
+// from the board instead.
+template <size_t FixedStride>
+void Bitboard::fillRows(const Bitboard& blocked, const Cell& from, Bitboard& out) {
+    const size_t S = FixedStride != 0 ? FixedStride : blocked.stride_;
+    const size_t rows = size_t(blocked.rowCount);
+    const uint64_t lastMask = blocked.lastMask;
+
+    // Open cells of word w of row y (padding rows are never open). The
+    // region only ever holds open cells and `from`, so or-ing it in admits
+    // a blocked start cell.
+    auto open = [&](size_t y, size_t w) {
+        size_t i = y * S + w;
+        return (~blocked.words[i] & (w + 1 == S ? lastMask : ~uint64_t(0))) | out.words[i];
+    };
+    auto grow = [&](size_t y, size_t neighbour) {
+        uint64_t* cur = &out.words[y * S];
+        const uint64_t* nb = &out.words[neighbour * S];
+        uint64_t changed = 0;
+        uint64_t carry = 0;
+        for (size_t w = 0; w < S; ++w) {
+            uint64_t m = open(y, w);
+            uint64_t seeds = (nb[w] | carry) & m;
+            if (seeds & ~cur[w]) {
+                uint64_t filled = fillRuns(seeds | cur[w], m);
+                changed |= filled ^ cur[w];
+                cur[w] = filled;
+            }
+            carry = cur[w] >> 63;
+        }
+        for (size_t w = S - 1; w-- > 0; ) {
+            uint64_t m = open(y, w);
+            uint64_t seeds = (cur[w + 1] << 63) & m;
+            if (seeds & ~cur[w]) {
+                uint64_t filled = fillRuns(seeds | cur[w], m);
+                changed |= filled ^ cur[w];
+                cur[w] = filled;
+            }
+        }
+        return changed;
+    };
+
+    const size_t fromRow = size_t(from.y) + 1;
+    const size_t fromWord = fromRow * S + size_t(from.x >> 6);
+    out.words[fromWord] = fillRuns(out.words[fromWord], open(fromRow, size_t(from.x >> 6)));
+    grow(fromRow, fromRow);
+    for (;;) {
+        uint64_t changed = 0;
+        for (size_t y = 1; y <= rows; ++y) changed |= grow(y, y - 1);
+        for (size_t y = rows; y >= 1; --y) changed |= grow(y, y + 1);
+        if (changed == 0) break;
+    }
+}
+
+SnakeSim::SnakeSim(uint64_t seed, int columns, int rows)
+    : rng(seed)
+    , freeCells(0)
+    , snake(0)
+{
+    setBoardSize(columns, rows);
+    reset(1);
+}
+
+void SnakeSim::setBoardSize(int columns, int rows) {
+    wantCols = std::clamp(columns, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+    wantRows = std::clamp(rows, MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+}
+
+// Everything sized by the board; the contents are rebuilt by reset()
+void SnakeSim::allocateBoard() {
+    cols = wantCols;
+    rowCount = wantRows;
+    const size_t cells = size_t(cols) * size_t(rowCount);
+    grid.assign(cells, CellWall);
+    freeCells = FreeCellIndex(cells);
+    snake = SnakeBody(cells);
+    blockedBits.resize(cols, rowCount);
+    fillScratch.resize(cols, rowCount);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Occupancy
+// ─────────────────────────────────────────────────────────────────────────────
+
+CellKind SnakeSim::cellAt(const Cell& c) const {
+    return inBounds(c) ? CellKind(grid[index(c)]) : CellWall;
+}
+
+int SnakeSim::reachableFrom(const Cell& from) const {
+    if (!inBounds(from)) return 0;
+    Bitboard::floodFill(blockedBits, from, fillScratch);
+    return fillScratch.count() - (blockedBits.test(from) ? 1 : 0);
+}
+
+bool SnakeSim::blocked(const Cell& c) const {
+    CellKind k = cellAt(c);
+    return k == CellWall || k == CellObstacle || k == CellBody;
+}
+
+void SnakeSim::setCell(const Cell& c, CellKind kind) {
+    size_t id = index(c);
+    if (kind == CellEmpty) freeCells.insert(uint32_t(id));
+    else                   freeCells.erase(uint32_t(id));
+    grid[id] = kind;
+    if (kind == CellWall || kind == CellObstacle || kind == CellBody) blockedBits.set(c);
+    else                                                             blockedBits.reset(c);
+}
+
+bool SnakeSim::randomFreeCell(Cell& out) {
+    if (freeCells.size() == 0) return false;
+    out = cellOf(freeCells.at(rng.below(uint32_t(freeCells.size()))));
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Spawning
+// ─────────────────────────────────────────────────────────────────────────────
+
+void SnakeSim::spawnFood() {
+    // Obstacles and the body can wall off pockets of the board; only place
+    // food where the head can get to, sampling without replacement as in
+    // spawnObstacles. Usually the first draw is reachable.
+    Bitboard::floodFill(blockedBits, snake.front(), fillScratch);
+    const Bitboard& reachable = fillScratch;
+    size_t avail = freeCells.size();
+    while (avail > 0) {
+        size_t slot = rng.below(uint32_t(avail));
+        Cell c = cellOf(freeCells.at(slot));
+        if (reachable.test(c)) {
+            food = c;
+            setCell(food, CellFood);
+            return;
+        }
+        freeCells.swapSlots(slot, --avail);
+    }
+
+    if (randomFreeCell(food)) {
+        setCell(food, CellFood);
+    }
+    else {
+        // Fallback if no free cells (board is full)
+        food = { 1, 1 };
+    }
+}
+
+void SnakeSim::spawnBonus() {
+    if (randomFreeCell(bonus)) {
+        setCell(bonus, CellBonus);
+        bonusOn = true;
+        bonusLiveElapsed = 0.f;
+    }
+}
+
+void SnakeSim::clearBonus() {
+    if (bonusOn && grid[index(bonus)] == CellBonus) setCell(bonus, CellEmpty);
+    bonusOn = false;
+    bonusSpawnElapsed = 0.f;
+}
+
+void SnakeSim::clearObstacles() {
+    for (const auto& o : obstacles) setCell(o, CellEmpty);
+    obstacles.clear();
+}
+
+void SnakeSim::spawnObstacles(int lvl) {
+    clearObstacles();
+    if (!obstaclesOn) return;
+
+    const LayoutKey key{ cols, rowCount, lvl, layoutSeed };
+    std::shared_ptr<const LevelLayout> cached;
+    LevelLayout generated;
+    const LevelLayout* layout = &generated;
+    if (layouts) {
+        cached = layouts->get(key);
+        layout = cached.get();
+    }
+    else {
+        generated = generateLayout(key);
+    }
+
+    // Cells under the snake, food or bonus are left out, and so is the
+    // space just around the head; layouts stay connected with any cells
+    // left out, so this never seals off part of the board
+    const Cell h = snake.front();
+    for (const Cell& c : layout->obstacles) {
+        if (grid[index(c)] != CellEmpty) continue;
+        if (std::abs(c.x - h.x) <= 2 && std::abs(c.y - h.y) <= 2) continue;
+        obstacles.push_back(c);
+        setCell(c, CellObstacle);
+    }
+
+    // The next level's layout is built while this one is played
+    if (layouts) layouts->prefetch({ cols, rowCount, lvl + 1, layoutSeed });
+}
+
+void SnakeSim::respawnSnake() {
+    for (size_t i = 0; i < snake.size(); ++i) setCell(snake[i], CellEmpty);
+    snake.clear();
+
+    const Cell start = startCell();
+    CellKind under = CellKind(grid[index(start)]);
+    snake.pushFront(start);
+    setCell(start, CellBody);
+    prevTail = start;
+    dir = None;
+
+    // Never leave food or bonus hidden under the new snake
+    if (under == CellFood) spawnFood();
+    if (under == CellBonus) { bonusOn = false; spawnBonus(); }
+}
+
+void SnakeSim::reset(int startingLevel) {
+    // Empty interior with the free cells in scan order. Patching the previous
+    // game's board would leave the index in a history-dependent order, and
+    // the same random draws would then land on different cells.
+    if (cols != wantCols || rowCount != wantRows) allocateBoard();
+    freeCells.clear();
+    blockedBits.clear();
+    for (int y = 0; y < rowCount; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            bool border = x == 0 || y == 0 || x == cols - 1 || y == rowCount - 1;
+            if (border) {
+                blockedBits.set({ x, y });
+                continue;
+            }
+            grid[index({ x, y })] = CellEmpty;
+            freeCells.insert(uint32_t(index({ x, y })));
+        }
+    }
+    snake.clear();
+    obstacles.clear();
+    bonusOn = false;
+    bonusSpawnElapsed = 0.f;
+    const uint64_t seedHigh = rng.next();
+    layoutSeed = (seedHigh << 32) | rng.next();
+
+    respawnSnake();
+    level_ = startingLevel;
+    lives_ = INITIAL_LIVES;
+    score_ = 0;
+    moveDelay_ = INITIAL_MOVE_DELAY * std::pow(0.9f, float(level_ - 1));
+    nextLevelScore = 100 * level_;
+    bonusLiveElapsed = 0.f;
+    over = false;
+    death = DeathNone;
+    ticks = 0;
+    spawnObstacles(level_);
+    spawnFood();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Snapshots
+// ─────────────────────────────────────────────────────────────────────────────
+
+void SnakeSim::save(SimSnapshot& out) const {
+    out.columns = cols;
+    out.rows = rowCount;
+    out.rngState = rng.rawState();
+    out.ticks = ticks;
+    out.layoutSeed = layoutSeed;
+
+    // Tail to head, 2 bits per step (Direction - 1); resize() keeps the
+    // capacity, so a snapshot that has held this length before doesn't allocate
+    const size_t n = snake.size();
+    out.length = uint32_t(n);
+    out.tail = snake.back();
+    out.links.resize((n + 2) / 4);
+    uint8_t packed = 0;
+    for (size_t i = n - 1, k = 0; i > 0; --i, ++k) {
+        const Cell from = snake[i];
+        const Cell to = snake[i - 1];
+        const unsigned code = to.y < from.y ? 0 : to.y > from.y ? 1 : to.x < from.x ? 2 : 3;
+        packed |= uint8_t(code << (2 * (k & 3)));
+        if ((k & 3) == 3) {
+            out.links[k >> 2] = packed;
+            packed = 0;
+        }
+        else if (i == 1) {
+            out.links[k >> 2] = packed;
+        }
+    }
+
+    out.obstacleIds.resize(obstacles.size());
+    for (size_t i = 0; i < obstacles.size(); ++i) out.obstacleIds[i] = uint32_t(index(obstacles[i]));
+
+    out.prevTail = prevTail;
+    out.food = food;
+    out.bonus = bonus;
+    out.dir = uint8_t(dir);
+    out.death = uint8_t(death);
+    out.foodPlaced = inBounds(food) && grid[index(food)] == CellFood;
+    out.bonusOn = bonusOn;
+    out.over = over;
+    out.bonusSpawnElapsed = bonusSpawnElapsed;
+    out.bonusLiveElapsed = bonusLiveElapsed;
+    out.moveDelay = moveDelay_;
+    out.score = score_;
+    out.level = level_;
+    out.lives = lives_;
+    out.nextLevelScore = nextLevelScore;
+}
+
+bool SnakeSim::restore(const SimSnapshot& in) {
+    if (in.columns != cols || in.rows != rowCount || in.length == 0) return false;
+
+    // Take the present off the board: body, food, bonus, and the obstacles
+    // only if the snapshot has different ones (another level)
+    for (size_t i = 0; i < snake.size(); ++i) setCell(snake[i], CellEmpty);
+    if (inBounds(food) && grid[index(food)] == CellFood) setCell(food, CellEmpty);
+    if (bonusOn && grid[index(bonus)] == CellBonus) setCell(bonus, CellEmpty);
+    bool sameObstacles = obstacles.size() == in.obstacleIds.size();
+    for (size_t i = 0; sameObstacles && i < obstacles.size(); ++i) {
+        sameObstacles = index(obstacles[i]) == in.obstacleIds[i];
+    }
+    if (!sameObstacles) {
+        clearObstacles();
+        for (uint32_t id : in.obstacleIds) {
+            obstacles.push_back(cellOf(id));
+            setCell(obstacles.back(), CellObstacle);
+        }
+    }
+
+    // Put the snapshot's on, tail first
+    snake.clear();
+    Cell c = in.tail;
+    for (uint32_t k = 0; ; ++k) {
+        snake.pushFront(c);
+        setCell(c, CellBody);
+        if (k + 1 == in.length) break;
+        c = advance(c, Direction(1 + ((in.links[k >> 2] >> (2 * (k & 3))) & 3)));
+    }
+    food = in.food;
+    if (in.foodPlaced) setCell(food, CellFood);
+    bonus = in.bonus;
+    bonusOn = in.bonusOn;
+    if (bonusOn) setCell(bonus, CellBonus);
+
+    const bool newLevel = level_ != in.level;
+    rng.setRawState(in.rngState);
+    ticks = in.ticks;
+    layoutSeed = in.layoutSeed;
+    prevTail = in.prevTail;
+    dir = Direction(in.dir);
+    death = DeathCause(in.death);
+    over = in.over;
+    bonusSpawnElapsed = in.bonusSpawnElapsed;
+    bonusLiveElapsed = in.bonusLiveElapsed;
+    moveDelay_ = in.moveDelay;
+    score_ = in.score;
+    level_ = in.level;
+    lives_ = in.lives;
+    nextLevelScore = in.nextLevelScore;
+
+    if (newLevel && layouts && obstaclesOn) layouts->prefetch({ cols, rowCount, level_ + 1, layoutSeed });
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Tick
+// ─────────────────────────────────────────────────────────────────────────────
+
+unsigned SnakeSim::step(Direction input) {
+    if (over) return EvNone;
+
+    ++ticks;
+    bonusSpawnElapsed += moveDelay_;
+    if (bonusOn) bonusLiveElapsed += moveDelay_;
+
+    if (input != None && input != opposite(dir)) dir = input;
+    if (dir == None) return EvNone;
+
+    unsigned events = EvNone;
+
+    // 1) Advance head
+    Cell next = advance(snake.front(), dir);
+
+    // 2) Grow when eating, otherwise the tail moves out of the way this tick
+    bool grow = (next == food);
+    bool intoTail = !grow && next == snake.back();
+
+    // 3) Collision with border, obstacle or self
+    if (blocked(next) && !intoTail) {
+        switch (cellAt(next)) {
+        case CellObstacle: death = DeathObstacle; break;
+        case CellBody:     death = DeathSelf;     break;
+        default:           death = DeathWall;     break;
+        }
+        lives_--;
+        if (lives_ > 0) {
+            respawnSnake();
+            return events | EvLostLife;
+        }
+        over = true;
+        return events | EvLostLife | EvGameOver;
+    }
+    events |= EvMoved;
+    prevTail = snake.back();
+    if (!grow) {
+        setCell(snake.back(), CellEmpty);
+        snake.popBack();
+    }
+    snake.pushFront(next);
+    setCell(next, CellBody);
+
+    // 4) Eat food?
+    if (grow) {
+        events |= EvAteFood;
+        score_ += 10;
+        spawnFood();
+    }
+
+    // 5) Bonus spawn / expire / eat
+    if (!bonusOn && bonusSpawnElapsed > BONUS_SPAWN_INTERVAL) {
+        spawnBonus();
+    }
+    if (bonusOn && bonusLiveElapsed > BONUS_DURATION) {
+        clearBonus();
+    }
+    if (bonusOn && next == bonus) {
+        events |= EvAteBonus;
+        score_ += 50;
+        clearBonus();
+    }
+
+    // 6) Level progression
+    if (score_ >= nextLevelScore) {
+        events |= EvLevelUp;
+        level_++;
+        nextLevelScore += 100;
+        moveDelay_ *= 0.9f;
+        spawnObstacles(level_);   // a cached layout: no generation on the tick
+    }
+
+    return events;
+}
@@ -0,0 +1,400 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Headless simulation core
+//
+// Everything that decides what happens on a move tick lives here: movement,
+// collision, food/bonus spawning, lives and level progression. No SFML types
+// are used, so the engine can be stepped without a window (benchmarks, bots,
+// build machines). One call to step() is one move of the snake.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Board size in cells (the outermost ring is the border wall). The sim
+// takes its size at runtime; these are the size of the classic game.
+const int DEFAULT_COLUMNS = 40;
+const int DEFAULT_ROWS = 30;
+const int MIN_BOARD_SIDE = 8;
+const int MAX_BOARD_SIDE = 2048;
+
+const float BONUS_SPAWN_INTERVAL = 15.f;
+const float BONUS_DURATION = 5.f;
+const int   INITIAL_LIVES = 3;
+const float INITIAL_MOVE_DELAY = 0.20f;
+
+enum Direction { None, Up, Down, Left, Right };
+
+struct Cell {
+    int x = 0;
+    int y = 0;
+    bool operator==(const Cell& o) const { return x == o.x && y == o.y; }
+    bool operator!=(const Cell& o) const { return !(*this == o); }
+};
+
+// Bit flags returned by SnakeSim::step()
+enum StepEvent : unsigned {
+    EvNone = 0,
+    EvMoved = 1 << 0,          // the body advanced one cell (not set on death)
+    EvAteFood = 1 << 1,
+    EvAteBonus = 1 << 2,
+    EvLevelUp = 1 << 3,
+    EvLostLife = 1 << 4,
+    EvGameOver = 1 << 5,
+};
+
+// What occupies a board cell (one byte per cell in SnakeSim's grid).
+// Food and bonus are recorded so spawners skip them; they do not block.
+enum CellKind : uint8_t { CellEmpty, CellWall, CellObstacle, CellBody, CellFood, CellBonus };
+
+// What the snake ran into when it last lost a life
+enum DeathCause { DeathNone, DeathWall, DeathObstacle, DeathSelf };
+
+Direction opposite(Direction d);
+Cell      advance(Cell c, Direction d);
+
+// Small seedable PRNG (splitmix64 seeding + xorshift64*) used instead of
+// std::rand() so a seed fully determines a run.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        state = (z ^ (z >> 31)) | 1;
+    }
+
+    uint32_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return static_cast<uint32_t>((state * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    // Uniform value in [0, n)
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>((uint64_t(next()) * n) >> 32);
+    }
+
+    // Raw generator state, for snapshots: putting it back repeats the draws
+    // (zero, the one state xorshift never leaves, can't come from next())
+    uint64_t rawState() const { return state; }
+    void     setRawState(uint64_t s) { state = s != 0 ? s : 1; }
+
+private:
+    uint64_t state = 1;
+};
+
+// Snake body as a fixed-capacity circular buffer of cells. Index 0 is the
+// head. pushFront/popBack are O(1) and never allocate after construction.
+class SnakeBody {
+public:
+    explicit SnakeBody(size_t capacity)
+        : buf(capacity)
+    {
+    }
+
+    size_t size() const { return count; }
+    bool   empty() const { return count == 0; }
+    size_t capacity() const { return buf.size(); }
+
+    Cell operator[](size_t i) const { return buf[wrap(first + i)]; }
+    Cell front() const { return buf[first]; }
+    Cell back() const { return buf[wrap(first + count - 1)]; }
+
+    void clear() { first = 0; count = 0; }
+
+    void pushFront(const Cell& c) {
+        first = (first == 0 ? buf.size() : first) - 1;
+        buf[first] = c;
+        ++count;
+    }
+
+    void popBack() { --count; }
+
+private:
+    size_t wrap(size_t i) const { return i >= buf.size() ? i - buf.size() : i; }
+
+    std::vector<Cell> buf;
+    size_t first = 0;
+    size_t count = 0;
+};
+
+// Set of free cell ids kept as a dense array plus a position map, so
+// insert/erase (swap-remove) and picking a uniformly random member are O(1)
+// and nothing allocates after construction.
+class FreeCellIndex {
+public:
+    static constexpr uint32_t NPOS = 0xFFFFFFFFu;
+
+    explicit FreeCellIndex(size_t cells)
+        : pos(cells, NPOS)
+    {
+        dense.reserve(cells);
+    }
+
+    size_t   size() const { return dense.size(); }
+    bool     contains(uint32_t id) const { return pos[id] != NPOS; }
+    uint32_t at(size_t slot) const { return dense[slot]; }
+
+    void insert(uint32_t id) {
+        if (pos[id] != NPOS) return;
+        pos[id] = uint32_t(dense.size());
+        dense.push_back(id);
+    }
+
+    void erase(uint32_t id) {
+        uint32_t slot = pos[id];
+        if (slot == NPOS) return;
+        uint32_t last = dense.back();
+        dense[slot] = last;
+        pos[last] = slot;
+        dense.pop_back();
+        pos[id] = NPOS;
+    }
+
+    void clear() {
+        for (uint32_t id : dense) pos[id] = NPOS;
+        dense.clear();
+    }
+
+    // Reorders two members; used to partition candidates during sampling
+    void swapSlots(size_t a, size_t b) {
+        std::swap(dense[a], dense[b]);
+        pos[dense[a]] = uint32_t(a);
+        pos[dense[b]] = uint32_t(b);
+    }
+
+private:
+    std::vector<uint32_t> dense;
+    std::vector<uint32_t> pos;
+};
+
+// One bit per board cell. Each row is stride() 64-bit words (column x is
+// bit x % 64 of word x / 64), so the default board is one word per row and
+// a 1000-column board sixteen. Moving every cell one step is a word shift
+// (left/right) or a row offset (up/down), which makes flood fills and "what
+// can the snake reach" queries cheap. A zero row is kept above and below
+// the board so vertical neighbours need no bounds checks.
+class Bitboard {
+public:
+    Bitboard() = default;
+    Bitboard(int columns, int rows) { resize(columns, rows); }
+
+    // Sets the size and clears every cell. The storage is reused when it is
+    // big enough, so resizing to the same size never allocates.
+    void resize(int columns, int rows);
+
+    int    columns() const { return cols; }
+    int    rows() const { return rowCount; }
+    size_t stride() const { return stride_; }
+
+    void clear();
+    bool test(const Cell& c) const { return (words[wordOf(c)] >> (c.x & 63)) & 1; }
+    void set(const Cell& c) { words[wordOf(c)] |= uint64_t(1) << (c.x & 63); }
+    void reset(const Cell& c) { words[wordOf(c)] &= ~(uint64_t(1) << (c.x & 63)); }
+
+    // Words of row y; rows -1 and rows() are the zero padding
+    const uint64_t* row(int y) const { return &words[size_t(y + 1) * stride_]; }
+
+    int  count() const;
+    bool operator==(const Bitboard& o) const;
+
+    // Every cell of the board that is not set here
+    Bitboard complement() const;
+    // Every set cell moved one step in `d`; cells pushed off the board vanish
+    Bitboard shifted(Direction d) const;
+
+    // Cells connected to `from` through cells that are not set in `blocked`
+    // (4-neighbourhood), written to `out` (resized to match, storage reused).
+    // `from` itself is always included, so it may be a blocked head cell.
+    // Common row widths run a version compiled for their word count.
+    static void floodFill(const Bitboard& blocked, const Cell& from, Bitboard& out);
+    // The same fill with the row width only known at run time, which every
+    // other width uses; for comparing against the specialised versions
+    static void floodFillGeneric(const Bitboard& blocked, const Cell& from, Bitboard& out);
+
+private:
+    static void fillNarrow(const Bitboard& blocked, const Cell& from, Bitboard& out);
+    template <size_t FixedStride>
+    static void fillRows(const Bitboard& blocked, const Cell& from, Bitboard& out);
+
+    size_t   wordOf(const Cell& c) const { return size_t(c.y + 1) * stride_ + size_t(c.x >> 6); }
+    // Bits of word w of a row that are on the board
+    uint64_t wordMask(size_t w) const { return w + 1 == stride_ ? lastMask : ~uint64_t(0); }
+
+    int      cols = 0;
+    int      rowCount = 0;
+    size_t   stride_ = 0;           // words per row
+    uint64_t lastMask = 0;          // on-board bits of a row's last word
+    std::vector<uint64_t> words;    // (rows + 2) * stride, row -1 first
+};
+
+class LayoutCache;
+
+// A SnakeSim game at one tick, compactly: the body is its tail plus 2 bits
+// per segment (the way to the next one towards the head), the obstacles are
+// cell ids, the rest is scalars. A snapshot that is reused only allocates
+// when it has to hold a longer snake or more obstacles than it has before.
+//
+// SnakeSim::restore() puts back the board and every value the rules read,
+// exactly. It does not put back the order of the free-cell index, so food
+// and bonus spawned after a restore can land elsewhere than they did the
+// first time through; a restore is still deterministic, which is all a
+// replay needs.
+struct SimSnapshot {
+    int      columns = 0;
+    int      rows = 0;
+    uint64_t rngState = 0;
+    uint64_t ticks = 0;
+    uint64_t layoutSeed = 0;
+    Cell     tail;
+    uint32_t length = 0;
+    std::vector<uint8_t>  links;        // 4 segments per byte, tail end first
+    std::vector<uint32_t> obstacleIds;  // in placement order
+    Cell     prevTail;
+    Cell     food;
+    Cell     bonus;
+    uint8_t  dir = None;
+    uint8_t  death = DeathNone;
+    bool     foodPlaced = false;        // false when the board had no room for food
+    bool     bonusOn = false;
+    bool     over = false;
+    float    bonusSpawnElapsed = 0.f;
+    float    bonusLiveElapsed = 0.f;
+    float    moveDelay = INITIAL_MOVE_DELAY;
+    int      score = 0;
+    int      level = 1;
+    int      lives = INITIAL_LIVES;
+    int      nextLevelScore = 100;
+};
+
+class SnakeSim {
+public:
+    explicit SnakeSim(uint64_t seed = 1, int columns = DEFAULT_COLUMNS, int rows = DEFAULT_ROWS);
+
+    void reseed(uint64_t seed) { rng.reseed(seed); }
+
+    // Board size in cells, clamped to [MIN_BOARD_SIDE, MAX_BOARD_SIDE].
+    // Takes effect at the next reset(), which reallocates only when the size
+    // actually changes.
+    void setBoardSize(int columns, int rows);
+    int  columns() const { return cols; }
+    int  rows() const { return rowCount; }
+
+    // Level obstacles on (the game) or off (lets bots reach full-board
+    // lengths). Takes effect at the next reset() or level-up.
+    void setObstaclesEnabled(bool on) { obstaclesOn = on; }
+
+    // Level layouts (LevelGen.h) come from `cache` when one is set, which
+    // builds the next level's layout on its worker thread while the current
+    // one is played; otherwise they are generated on the spot. The layouts
+    // are the same either way. The cache must outlive its use by the sim.
+    void setLayoutCache(LayoutCache* cache) { layouts = cache; }
+
+    // Start a new game at the given level (what the Play/Retry buttons do).
+    // The board is rebuilt from scratch, so reseed() followed by reset()
+    // always produces the same game no matter what was played before.
+    void reset(int startingLevel);
+
+    // Copy the game out to a snapshot and back. Both cost O(length of the
+    // snake + obstacles), not O(board). restore() refuses (returns false) a
+    // snapshot taken on a board of another size.
+    void save(SimSnapshot& out) const;
+    bool restore(const SimSnapshot& in);
+
+    // Advance one move tick. `input` is the requested direction (None keeps
+    // the current heading); reversing onto the neck is ignored. While the
+    // snake is waiting for its first input the tick only advances the timers.
+    // Returns a mask of StepEvent flags.
+    unsigned step(Direction input);
+
+    // True if moving into `c` would kill the snake (border, obstacle, body).
+    // Constant time: a lookup in the occupancy grid.
+    bool blocked(const Cell& c) const;
+    CellKind cellAt(const Cell& c) const;
+
+    // Border, obstacles and body as a bitboard, kept in sync with the grid
+    const Bitboard& blockedCells() const { return blockedBits; }
+    // Number of free cells reachable from `from` without passing through
+    // a blocked cell (the body counts as blocked everywhere, tail included)
+    int reachableFrom(const Cell& from) const;
+
+    const SnakeBody&         body() const { return snake; }
+    const std::vector<Cell>& obstacleCells() const { return obstacles; }
+    Cell      head() const { return snake.front(); }
+    // Tail cell before the most recent move. Segment i was previously at
+    // body()[i + 1], and the last segment at previousTail(), which lets the
+    // renderer interpolate between ticks.
+    Cell      previousTail() const { return prevTail; }
+    Direction heading() const { return dir; }
+    Cell      foodCell() const { return food; }
+    Cell      bonusCell() const { return bonus; }
+    bool      bonusActive() const { return bonusOn; }
+
+    int      score() const { return score_; }
+    int      level() const { return level_; }
+    int      lives() const { return lives_; }
+    float    moveDelay() const { return moveDelay_; }
+    bool     gameOver() const { return over; }
+    DeathCause lastDeath() const { return death; }
+    uint64_t tick() const { return ticks; }
+
+private:
+    bool   inBounds(const Cell& c) const {
+        return c.x >= 0 && c.x < cols && c.y >= 0 && c.y < rowCount;
+    }
+    size_t index(const Cell& c) const { return size_t(c.y) * size_t(cols) + size_t(c.x); }
+    Cell   cellOf(uint32_t id) const { return { int(id % uint32_t(cols)), int(id / uint32_t(cols)) }; }
+    Cell   startCell() const { return { cols / 2, rowCount / 2 }; }
+
+    void allocateBoard();
+
+    // All grid writes go through here so the free-cell index stays in sync
+    void setCell(const Cell& c, CellKind kind);
+    bool randomFreeCell(Cell& out);
+
+    void spawnFood();
+    void spawnBonus();
+    void spawnObstacles(int lvl);
+    void respawnSnake();
+    void clearObstacles();
+    void clearBonus();
+
+    Rng               rng;
+    int               cols = 0;    // current board size
+    int               rowCount = 0;
+    int               wantCols;    // size for the next reset()
+    int               wantRows;
+    std::vector<uint8_t> grid;     // cols x rowCount CellKind, updated on every head/tail/obstacle change
+    Bitboard          blockedBits; // cells of grid that are wall, obstacle or body
+    mutable Bitboard  fillScratch; // flood fill output for reachableFrom() and spawnFood()
+    FreeCellIndex     freeCells;   // every CellEmpty cell (interior only)
+    SnakeBody         snake;       // front() is the head
+    std::vector<Cell> obstacles;
+    LayoutCache*      layouts = nullptr;
+    uint64_t          layoutSeed = 0;  // drawn by reset(); seeds every level's layout
+    Direction         dir = None;
+    Cell              prevTail;
+
+    Cell food{ 1, 1 };
+    Cell bonus{ 0, 0 };
+    bool bonusOn = false;
+    float bonusSpawnElapsed = 0.f; // sim-time seconds, advanced by moveDelay per tick
+    float bonusLiveElapsed = 0.f;
+
+    int   score_ = 0;
+    int   level_ = 1;
+    int   lives_ = INITIAL_LIVES;
+    int   nextLevelScore = 100;
+    float moveDelay_ = INITIAL_MOVE_DELAY;
+    bool  over = false;
+    bool  obstaclesOn = true;
+    DeathCause death = DeathNone;
+    uint64_t ticks = 0;
+};
@@ -6,139 +6,340 @@
 #include <cstdlib>
 #include <cmath>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <chrono>
+
+#include "SnakeSim.h"
+#include "Renderer.h"
+#include "Ui.h"
+#include "Input.h"
+#include "Replay.h"
+#include "Autopilot.h"
+#include "Profiler.h"
+#include "Assets.h"
+#include "Mixer.h"
+#include "StatsStore.h"
+#include "LevelGen.h"
+#include "ArenaSim.h"
+#include "Netplay.h"
+#include "Rewind.h"
+#include "VideoExport.h"
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Constants
 // ─────────────────────────────────────────────────────────────────────────────
 
-const unsigned int WINDOW_WIDTH = 800;
-const unsigned int WINDOW_HEIGHT = 600;
+// Gameplay constants live in SnakeSim.h. The window fits the default board
+// at the default cell size; other boards (--board, --cell) are shown
+// through a camera that follows the snake.
 const float        BLOCK_SIZE = 20.f;
-const unsigned int COLUMNS = WINDOW_WIDTH / static_cast<unsigned>(BLOCK_SIZE);
-const unsigned int ROWS = WINDOW_HEIGHT / static_cast<unsigned>(BLOCK_SIZE);
-
-const float BONUS_SPAWN_INTERVAL = 15.f;
-const float BONUS_DURATION = 5.f;
-const int   INITIAL_LIVES = 3;
-
-// Colors
-const sf::Color BG_COLOR1 = sf::Color(34, 139, 34); // ForestGreen
-const sf::Color BG_COLOR2 = sf::Color(46, 160, 46); // lighter
-const sf::Color OBSTACLE_COLOR = sf::Color::Red;           // bright red
-const sf::Color BONUS_COLOR = sf::Color::Yellow;
-const sf::Color BORDER_COLOR = sf::Color(105, 105, 105); // DimGray
+const unsigned int WINDOW_WIDTH = DEFAULT_COLUMNS * static_cast<unsigned>(BLOCK_SIZE);
+const unsigned int WINDOW_HEIGHT = DEFAULT_ROWS * static_cast<unsigned>(BLOCK_SIZE);
+const float        MIN_CELL_SIZE = 2.f;
+const float        MAX_CELL_SIZE = 64.f;
+
+// Fixed-timestep loop limits: at most this many sim ticks per rendered
+// frame, and frame times above MAX_FRAME_TIME (window drag, breakpoints) are
+// clamped instead of being caught up.
+const int   MAX_TICKS_PER_FRAME = 8;
+const float MAX_FRAME_TIME = 0.25f;
+
+// Arena mode: one snake per ARENA_CELLS_PER_AGENT cells of the board (the
+// player's included), as much food as snakes, and a fixed tick
+const int   ARENA_CELLS_PER_AGENT = 100;
+const int   ARENA_MIN_AGENTS = 4;
+const int   ARENA_MAX_AGENTS = 500;
+const float ARENA_MOVE_DELAY = 0.12f;
+
+// Versus (--host / --join): two players, no bots, on the arena's tick
+const int   VERSUS_FOOD = 4;
+
+// Backspace takes the game back this far (as many ticks as that is at the
+// current speed, up to what the rewind buffer keeps)
+const float REWIND_SECONDS = 3.f;
+
+// Menus, pause and game over are drawn on demand: the loop sleeps in
+// waitEvent() until input arrives, and redraws at least this often anyway
+// (covers window systems that lose the contents without telling us)
+const sf::Time IDLE_REDRAW_INTERVAL = sf::seconds(1.f);
+
+// --video: frames per second of the exported video. With --replay the
+// replay is rendered offscreen at exactly this rate (as fast as the encoder
+// keeps up) and the program exits when it ends; otherwise the session is
+// captured live against the wall clock.
+const unsigned VIDEO_FPS = 30;
+
+// Every game is recorded; the most recent one is written here when it ends
+const char* const LAST_REPLAY_FILE = "last_replay.snkr";
+const char* const STATS_FILE = "stats.dat";
+
+// F4 starts a profiler capture; stopping it writes a Chrome trace here
+const char* const TRACE_FILE = "trace.json";
+
+// Taken during static initialisation, as close to process start as portable
+// code gets; the startup report is measured from here
+static const std::chrono::steady_clock::time_point PROCESS_START = std::chrono::steady_clock::now();
+
+static double msSinceStart() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - PROCESS_START).count();
+}
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Enums & Structs
 // ─────────────────────────────────────────────────────────────────────────────
 
-enum Direction { None, Up, Down, Left, Right };
 enum GameState { MainMenu, LevelSelect, Playing, Paused, GameOver };
-
-struct Button {
-    sf::RectangleShape box;
-    sf::Text           label;
-    Button(const sf::Font& font, const sf::String& str, unsigned charSize)
-        : label(font, str, charSize)
-    {
-    }
-    bool contains(const sf::Vector2i& m) const {
-        return box.getGlobalBounds()
-            .contains(sf::Vector2f{ float(m.x), float(m.y) });
-    }
-};
-
-static void centerText(sf::Text& txt, float x, float y) {
-    auto b = txt.getLocalBounds();
-    txt.setOrigin({ b.size.x / 2.f, b.size.y / 2.f });
-    txt.setPosition({ x, y });
-}
+enum FramePacing { Capped60, VSync, Uncapped };
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Main
 // ─────────────────────────────────────────────────────────────────────────────
 
-int main() {
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-
-    // 1) Load font & sounds via SFML 3 constructors
-    sf::Font font;
-    try {
-        font = sf::Font("arial.ttf");
+int main(int argc, char** argv) {
+    // 0) Command line: --replay <file> [--speed <multiplier>]
+    //                   --board <columns>x<rows>  --cell <pixels>
+    //                   --host <port> | --join <host>:<port>  [--lag <ms>]
+    //                   --video <file.y4m|file.rgba>  [--video-fps <n>]
+    std::string replayPath;
+    std::string videoPath;
+    unsigned videoFps = VIDEO_FPS;
+    int   hostPort = 0;
+    std::string joinAddress;
+    int   lagMs = 0;
+    float replaySpeed = 1.f;
+    int   boardColumns = DEFAULT_COLUMNS;
+    int   boardRows = DEFAULT_ROWS;
+    float cellSize = BLOCK_SIZE;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            replaySpeed = std::max(0.125f, float(std::atof(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &boardColumns, &boardRows) != 2) {
+                std::cerr << "Error: --board takes a size like 100x80\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[i], "--cell") == 0 && i + 1 < argc) {
+            cellSize = std::clamp(float(std::atof(argv[++i])), MIN_CELL_SIZE, MAX_CELL_SIZE);
+        }
+        else if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            hostPort = std::atoi(argv[++i]);
+            if (hostPort <= 0 || hostPort > 0xFFFF) {
+                std::cerr << "Error: --host takes a port number\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+            joinAddress = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--lag") == 0 && i + 1 < argc) {
+            lagMs = std::max(std::atoi(argv[++i]), 0);
+        }
+        else if (std::strcmp(argv[i], "--video") == 0 && i + 1 < argc) {
+            videoPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--video-fps") == 0 && i + 1 < argc) {
+            videoFps = unsigned(std::clamp(std::atoi(argv[++i]), 1, 240));
+        }
     }
-    catch (...) {
-        std::cerr << "Error: could not load arial.ttf\n";
+
+    ReplayReader replay;
+    if (!replayPath.empty() && !replay.load(replayPath)) {
+        std::cerr << "Error: " << replayPath << " is not a valid replay\n";
         return EXIT_FAILURE;
     }
 
-    sf::SoundBuffer gameOverBuf, eatBuf;
-    try {
-        gameOverBuf = sf::SoundBuffer("gameover.wav");
-    }
-    catch (...) {
-        std::cerr << "Warning: could not load gameover.wav\n";
-    }
-    try {
-        eatBuf = sf::SoundBuffer("eat.wav");
-    }
-    catch (...) {
-        std::cerr << "Warning: could not load eat.wav\n";
+    // 1) Font & sounds decode on a worker thread (from assets.pak if present)
+    AssetLoader loader;
+    loader.start(ASSET_PACK_FILE);
+
+    // High scores and totals: read now, written in the background from here on
+    StatsStore stats(STATS_FILE);
+    if (!stats.load()) {
+        std::cerr << "Warning: " << STATS_FILE << " was damaged; kept what could be read\n";
     }
-    sf::Sound gameOverSound(gameOverBuf);
-    sf::Sound eatSound(eatBuf);
+    stats.start();
 
-    // 2) Create window (SFML 3)
+    // 2) Create window (SFML 3) while the assets load
     sf::VideoMode vm{ sf::Vector2u{ WINDOW_WIDTH, WINDOW_HEIGHT } };
     sf::RenderWindow window(vm, "Snake Game");
-    window.setFramerateLimit(60);
-
-    // 3) Game variables
-    std::vector<sf::Vector2f> snake;
-    Direction dir = None;
-    sf::Clock moveClock;
-    float    moveDelay = 0.20f;
-
-    sf::Vector2u foodCell{ std::rand() % COLUMNS, std::rand() % ROWS };
-    sf::Vector2u bonusCell{ 0, 0 };
-    bool         bonusActive = false;
-    sf::Clock    bonusSpawnClock, bonusLiveClock;
-
-    int  score = 0;
-    int  level = 1;
-    int  lives = INITIAL_LIVES;
-    int  highScore = 0;
+    FramePacing pacing = Capped60;   // F2 cycles 60 FPS cap / vsync / uncapped
+    auto applyPacing = [&]() {
+        window.setVerticalSyncEnabled(pacing == VSync);
+        window.setFramerateLimit(pacing == Capped60 ? 60 : 0);
+        };
+    applyPacing();
+    const double windowMs = msSinceStart();
+
+    // --video: every frame is drawn into `canvas` instead, copied to the
+    // window, and read back into the video writer's queue
+    VideoWriter video;
+    sf::RenderTexture canvas;
+    const bool exporting = !videoPath.empty() && !replayPath.empty();
+    if (!videoPath.empty()) {
+        if (!canvas.resize({ WINDOW_WIDTH, WINDOW_HEIGHT }) ||
+            !video.start(videoPath, WINDOW_WIDTH, WINDOW_HEIGHT, videoFps))
+        {
+            std::cerr << "Error: could not start the video export to " << videoPath << "\n";
+            return EXIT_FAILURE;
+        }
+        if (exporting) {
+            pacing = Uncapped;
+            applyPacing();
+        }
+    }
+    sf::RenderTarget& screen = videoPath.empty() ? static_cast<sf::RenderTarget&>(window) : canvas;
+    double   videoStart = -1.0;     // wall clock of the first live frame
+    uint64_t videoDue = 0;          // frames of video the next capture brings it up to
+
+    // 3) Game variables (all gameplay state lives in the simulation)
+    LayoutCache layouts;        // builds the next level's obstacles in the background
+    SnakeSim  sim(1, boardColumns, boardRows);
+    sim.setLayoutCache(&layouts);
+    Rng       gameSeeds(static_cast<uint64_t>(std::time(nullptr)));
+    InputQueue input;           // timestamped key presses, one turn per tick
+    ReplayWriter recorder;      // seed + turns of the game in progress
+    bool      watching = false;      // sim is driven by `replay`, not the keyboard
+    Autopilot autopilot;             // T cycles off / A* / Hamiltonian cycle
+    bool      autopilotOn = false;
+    bool      assisted = false;      // autopilot or a rewind played part of this game: no high score
+    RewindBuffer history;            // last few seconds and level starts, for Backspace / R
+    float     tickAccumulator = 0.f; // unsimulated time carried between frames
+    bool      interpolate = false;   // last tick moved the body
+
+    uint64_t gameSeed = 0;
     int  startingLevel = 1;
-    int  nextLevelScore = 100;  // Score needed to reach next level
 
-    std::vector<sf::Vector2u> obstacles;
+    ArenaSim  arena;                 // Arena mode: the player is agent 0, bots the rest
+    bool      arenaOn = false;
+    int       arenaLives = 0;
+    std::vector<Direction> arenaInputs;
+    Rng       arenaBots(1);
 
-    // 4) Pre-create border shapes
-    sf::RectangleShape borderTop, borderBottom, borderLeft, borderRight;
-    borderTop.setSize({ float(WINDOW_WIDTH), BLOCK_SIZE });
-    borderTop.setPosition({ 0.f, 0.f });
-    borderTop.setFillColor(BORDER_COLOR);
+    VersusSession versus;            // Versus: the arena with the other player over UDP
+    bool      versusOn = false;
+    Direction versusTurn = None;     // a turn still waiting for the session to tick
+    int       versusLoser = -1;      // agent that lost, 2 for a draw, -1 if none (yet)
 
-    borderBottom.setSize({ float(WINDOW_WIDTH), BLOCK_SIZE });
-    borderBottom.setPosition({ 0.f, float(WINDOW_HEIGHT - BLOCK_SIZE) });
-    borderBottom.setFillColor(BORDER_COLOR);
+    // 4) Board background (checkerboard + border), baked for the visible
+    //    cells in one vertex array
+    BoardBackground background;
 
-    borderLeft.setSize({ BLOCK_SIZE, float(WINDOW_HEIGHT) });
-    borderLeft.setPosition({ 0.f, 0.f });
-    borderLeft.setFillColor(BORDER_COLOR);
+    EntityBatch entities;
+    if (!entities.init()) {
+        std::cerr << "Error: could not create entity atlas texture\n";
+        return EXIT_FAILURE;
+    }
 
-    borderRight.setSize({ BLOCK_SIZE, float(WINDOW_HEIGHT) });
-    borderRight.setPosition({ float(WINDOW_WIDTH - BLOCK_SIZE), 0.f });
-    borderRight.setFillColor(BORDER_COLOR);
+    // Loading screen: a progress bar (no font yet) until the worker is done
+    double firstFrameMs = -1.0;
+    {
+        sf::RectangleShape barFrame({ 300.f, 20.f });
+        barFrame.setFillColor(sf::Color(0, 100, 0));
+        barFrame.setPosition({ WINDOW_WIDTH / 2.f - 150.f, WINDOW_HEIGHT / 2.f - 10.f });
+        sf::RectangleShape bar;
+        bar.setFillColor(sf::Color::White);
+        bar.setPosition(barFrame.getPosition());
+        while (!loader.ready()) {
+            while (auto event = window.pollEvent()) {
+                if (event->is<sf::Event::Closed>()) return EXIT_SUCCESS;   // loader joins its worker
+            }
+            bar.setSize({ 300.f * loader.progress(), 20.f });
+            window.clear(sf::Color::Green);
+            window.draw(barFrame);
+            window.draw(bar);
+            window.display();
+            if (firstFrameMs < 0.0) firstFrameMs = msSinceStart();
+        }
+    }
+    const double assetsMs = msSinceStart();
 
-    sf::Text infoText(font, "", 20);
-    infoText.setFillColor(sf::Color::White);
+    GameAssets& assets = loader.assets();
+    for (const std::string& w : loader.warnings()) std::cerr << "Warning: " << w << "\n";
+    if (!assets.fontLoaded) {
+        std::cerr << "Error: the game can't run without " << FONT_FILE << "\n";
+        return EXIT_FAILURE;
+    }
+    sf::Font& font = assets.font;
+    // Sound effects: a few voices per effect so quick eats overlap; the
+    // game-over sound outranks everything else
+    SfxMixer mixer;
+    mixer.addEffect(SfxEat, assets.eat, 4, 1);
+    mixer.addEffect(SfxBonus, assets.eat, 2, 2, 1.5f);
+    mixer.addEffect(SfxGameOver, assets.gameOver, 1, 3);
+
+    // Draw-call / frame-time counters (F1 toggles the stats line)
+    FrameStats frameStats;
+    sf::Clock  frameClock;
+    bool       showStats = false;
+    auto draw = [&](const sf::Drawable& d) {
+        screen.draw(d);
+        ++frameStats.drawCalls;
+        };
+
+    sf::Text statsText(font, "", 16);
+    statsText.setFillColor(sf::Color::White);
+    statsText.setPosition({ BLOCK_SIZE + 5.f, WINDOW_HEIGHT - BLOCK_SIZE - 45.f });
+
+    // Zone profiler: F3 shows the overlay, F4 starts/stops a Chrome trace
+    Profiler profiler;
+    bool     showProfile = false;
+    sf::Text profileText(font, "", 14);
+    profileText.setFillColor(sf::Color::White);
+    profileText.setOutlineColor(sf::Color::Black);
+    profileText.setOutlineThickness(1.f);
+    profileText.setPosition({ BLOCK_SIZE + 5.f, BLOCK_SIZE + 35.f });
+    // On-demand screens: `shown` is the state on screen and `redraw` says
+    // it may be out of date. Time and CPU spent on them are reported on exit.
+    GameState shown = MainMenu;
+    GameState drawing = MainMenu;   // state whose frame is being drawn
+    bool      redraw = true;
+    double    onDemandSeconds = 0.0;
+    double    onDemandCpu = 0.0;
+    uint64_t  onDemandFrames = 0;
+    // Live capture repeats a frame for as many video frames as went by since
+    // the last one; a frame the writer had no room for is covered by the
+    // next one's repeats. The offline export waits instead, one frame each.
+    auto captureFrame = [&]() {
+        ProfileScope scope(profiler, ZoneCapture);
+        canvas.display();
+        unsigned repeat = 1;
+        if (!exporting) {
+            const double now = msSinceStart() / 1000.0;
+            if (videoStart < 0.0) videoStart = now;
+            videoDue = std::max(videoDue, uint64_t((now - videoStart) * videoFps) + 1);
+            repeat = unsigned(std::min<uint64_t>(videoDue - video.framesQueued(), 10u * videoFps));
+        }
+        if (repeat > 0) {
+            const sf::Image frame = canvas.getTexture().copyToImage();
+            video.push(frame.getPixelsPtr(), repeat, exporting);
+        }
+        window.draw(sf::Sprite(canvas.getTexture()));
+        };
+    auto present = [&]() {
+        if (showProfile) draw(profileText);
+        if (video.active()) captureFrame();
+        ProfileScope scope(profiler, ZoneDisplay);
+        window.display();
+        shown = drawing;
+        redraw = false;
+        onDemandFrames += drawing != Playing ? 1 : 0;
+        };
+
+    UiText infoText(font, 20, sf::Color::White);
     infoText.setPosition({ BLOCK_SIZE + 5.f, BLOCK_SIZE + 5.f });
 
     sf::Text gameOverText(font, "Game Over!", 48);
     gameOverText.setFillColor(sf::Color::Red);
     centerText(gameOverText, WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f - 50.f);
 
-    sf::Text pauseText(font, "Paused\nPress P to Resume\nPress M for Menu", 32);
+    sf::Text pauseText(font, "Paused\nPress P to Resume\nPress M for Menu\nPress R to Restart Level", 32);
     pauseText.setFillColor(sf::Color::Black);
     centerText(pauseText, WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f);
 
@@ -147,9 +348,8 @@ int main() {
     titleText.setFillColor(sf::Color::Black);
     centerText(titleText, WINDOW_WIDTH / 2.f, 100.f);
 
-    sf::Text highScoreText(font, "", 24);
-    highScoreText.setFillColor(sf::Color::Black);
-    centerText(highScoreText, WINDOW_WIDTH / 2.f, 160.f);
+    UiText highScoreText(font, 24, sf::Color::Black);
+    highScoreText.centerOn(WINDOW_WIDTH / 2.f, 160.f);
 
     Button playButton(font, "Play", 24);
     playButton.box.setSize({ 200.f, 50.f });
@@ -159,14 +359,34 @@ int main() {
         playButton.box.getPosition().x + playButton.box.getSize().x / 2.f,
         playButton.box.getPosition().y + playButton.box.getSize().y / 2.f);
 
+    Button demoButton(font, "Demo", 24);
+    demoButton.box.setSize({ 200.f, 50.f });
+    demoButton.box.setFillColor({ 200,200,200 });
+    demoButton.box.setPosition({ WINDOW_WIDTH / 2.f - 100.f, 270.f });
+    centerText(demoButton.label,
+        demoButton.box.getPosition().x + demoButton.box.getSize().x / 2.f,
+        demoButton.box.getPosition().y + demoButton.box.getSize().y / 2.f);
+
+    Button arenaButton(font, "Arena", 24);
+    arenaButton.box.setSize({ 200.f, 50.f });
+    arenaButton.box.setFillColor({ 200,200,200 });
+    arenaButton.box.setPosition({ WINDOW_WIDTH / 2.f - 100.f, 340.f });
+    centerText(arenaButton.label,
+        arenaButton.box.getPosition().x + arenaButton.box.getSize().x / 2.f,
+        arenaButton.box.getPosition().y + arenaButton.box.getSize().y / 2.f);
+
     Button exitButton(font, "Exit", 24);
     exitButton.box.setSize({ 200.f, 50.f });
     exitButton.box.setFillColor({ 200,200,200 });
-    exitButton.box.setPosition({ WINDOW_WIDTH / 2.f - 100.f, 270.f });
+    exitButton.box.setPosition({ WINDOW_WIDTH / 2.f - 100.f, 410.f });
     centerText(exitButton.label,
         exitButton.box.getPosition().x + exitButton.box.getSize().x / 2.f,
         exitButton.box.getPosition().y + exitButton.box.getSize().y / 2.f);
 
+    sf::Text levelSelectText(font, "Select Level", 40);
+    levelSelectText.setFillColor(sf::Color::Black);
+    centerText(levelSelectText, WINDOW_WIDTH / 2.f, 100.f);
+
     std::vector<Button> levelButtons;
     for (int i = 1; i <= 5; ++i) {
         Button b(font, "Level " + std::to_string(i), 20);
@@ -191,13 +411,11 @@ int main() {
     gameOverTitle.setFillColor(sf::Color::Red);
     centerText(gameOverTitle, WINDOW_WIDTH / 2.f, 100.f);
 
-    sf::Text finalScoreText(font, "", 30);
-    finalScoreText.setFillColor(sf::Color::White);
-    centerText(finalScoreText, WINDOW_WIDTH / 2.f, 180.f);
+    UiText finalScoreText(font, 30, sf::Color::White);
+    finalScoreText.centerOn(WINDOW_WIDTH / 2.f, 180.f);
 
-    sf::Text gameOverHighScoreText(font, "", 30);
-    gameOverHighScoreText.setFillColor(sf::Color::White);
-    centerText(gameOverHighScoreText, WINDOW_WIDTH / 2.f, 220.f);
+    UiText gameOverHighScoreText(font, 30, sf::Color::White);
+    gameOverHighScoreText.centerOn(WINDOW_WIDTH / 2.f, 220.f);
 
     Button retryButton(font, "Retry", 24);
     retryButton.box.setSize({ 200.f, 50.f });
@@ -224,107 +442,230 @@ int main() {
         exitButtonGameOver.box.getPosition().y + exitButtonGameOver.box.getSize().y / 2.f);
 
     // 6) Helper lambdas
-    auto isCellFree = [&](const sf::Vector2u& cell) -> bool {
-        // Check obstacles
-        for (const auto& o : obstacles) {
-            if (o == cell) return false;
-        }
-
-        // Check snake
-        for (const auto& seg : snake) {
-            sf::Vector2u segCell(
-                static_cast<unsigned>(seg.x / BLOCK_SIZE),
-                static_cast<unsigned>(seg.y / BLOCK_SIZE)
-            );
-            if (segCell == cell) return false;
-        }
-
-        // Check bonus
-        if (bonusActive && cell == bonusCell) return false;
-
-        return true;
+    auto startGame = [&]() {
+        gameSeed = gameSeeds.next();
+        sim.setBoardSize(boardColumns, boardRows);
+        sim.reseed(gameSeed);
+        sim.reset(startingLevel);
+        history.begin(sim);
+        recorder.begin(gameSeed, startingLevel, sim.columns(), sim.rows());
+        watching = false;
+        arenaOn = false;
+        autopilot.forget();
+        assisted = autopilotOn;
+        input.clear();
+        tickAccumulator = 0.f;
+        interpolate = false;
         };
-
-    auto spawnFood = [&]() {
-        std::vector<sf::Vector2u> freeCells;
-
-        // Collect all free cells
-        for (unsigned y = 1; y < ROWS - 1; ++y) {
-            for (unsigned x = 1; x < COLUMNS - 1; ++x) {
-                sf::Vector2u cell(x, y);
-                if (isCellFree(cell)) {
-                    freeCells.push_back(cell);
-                }
-            }
-        }
-
-        // If free cells available, pick random one
-        if (!freeCells.empty()) {
-            foodCell = freeCells[std::rand() % freeCells.size()];
+    auto startReplay = [&]() {
+        sim.setBoardSize(replay.columns(), replay.rows());
+        sim.reseed(replay.seed());
+        sim.reset(replay.startingLevel());
+        history.begin(sim);
+        replay.rewind();
+        for (uint64_t to; replay.restorePending(to);) history.restore(sim, to);
+        watching = true;
+        arenaOn = false;
+        autopilotOn = false;
+        input.clear();
+        tickAccumulator = 0.f;
+        interpolate = false;
+        };
+    // After a rewind or level restart: the replay records where the game
+    // went back to, and nothing queued before it carries over
+    auto afterRestore = [&]() {
+        recorder.recordRestore(sim.tick());
+        assisted = true;
+        autopilot.forget();
+        input.clear();
+        tickAccumulator = 0.f;
+        interpolate = false;
+        };
+    auto startArena = [&]() {
+        ArenaConfig config;
+        config.columns = boardColumns;
+        config.rows = boardRows;
+        config.agents = std::clamp(boardColumns * boardRows / ARENA_CELLS_PER_AGENT,
+                                   ARENA_MIN_AGENTS, ARENA_MAX_AGENTS);
+        config.food = config.agents;
+        arena.reseed(gameSeeds.next());
+        arena.reset(config);
+        arenaInputs.assign(size_t(arena.agentCount()), None);
+        arenaOn = true;
+        arenaLives = INITIAL_LIVES;
+        watching = false;
+        autopilotOn = false;
+        input.clear();
+        tickAccumulator = 0.f;
+        };
+    // Hosts (or joins) a match; either way the game is on once the peers
+    // have found each other
+    auto startVersus = [&]() {
+        bool ok;
+        if (!joinAddress.empty()) {
+            NetAddress address;
+            ok = resolveAddress(joinAddress, address) && versus.join(address);
         }
         else {
-            // Fallback if no free cells (shouldn't normally happen)
-            foodCell = { 1, 1 };
+            ArenaConfig config;
+            config.columns = boardColumns;
+            config.rows = boardRows;
+            config.food = VERSUS_FOOD;
+            ok = versus.host(uint16_t(hostPort), config, gameSeeds.next());
         }
+        versusOn = ok;
+        arenaOn = ok;
+        if (!ok) return false;
+        versus.setLag(lagMs);
+        versusTurn = None;
+        versusLoser = -1;
+        watching = false;
+        autopilotOn = false;
+        input.clear();
+        tickAccumulator = 0.f;
+        return true;
         };
-
-    auto spawnObstacles = [&](int lvl) {
-        obstacles.clear();
-        int count = std::min((lvl - 1) * 2, 40);
-        while ((int)obstacles.size() < count) {
-            sf::Vector2u cell{
-                unsigned(1 + std::rand() % (COLUMNS - 2)),
-                unsigned(1 + std::rand() % (ROWS - 2))
-            };
-
-            // Skip if cell is not free
-            if (!isCellFree(cell)) continue;
-
-            // Skip if cell is near starting position
-            sf::Vector2u startCell(COLUMNS / 2, ROWS / 2);
-            if (std::abs(static_cast<int>(cell.x) - static_cast<int>(startCell.x)) < 5 &&
-                std::abs(static_cast<int>(cell.y) - static_cast<int>(startCell.y)) < 5)
-            {
-                continue;
-            }
-
-            obstacles.push_back(cell);
-        }
+    auto leaveVersus = [&]() {
+        versus.close();
+        versusOn = false;
+        arenaOn = false;
+        };
+    // 1 + the number of snakes with a higher score than the player's
+    auto arenaRank = [&]() {
+        int rank = 1;
+        for (int i = 1; i < arena.agentCount(); ++i) rank += arena.score(i) > arena.score(0) ? 1 : 0;
+        return rank;
         };
 
-    auto startGame = [&]() {
-        snake.clear();
-        snake.push_back({ WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f });
-        dir = None;
-        level = startingLevel;
-        lives = INITIAL_LIVES;
-        score = 0;
-        moveDelay = 0.20f * std::pow(0.9f, level - 1);
-        nextLevelScore = 100 * level;
-        bonusActive = false;
-        bonusSpawnClock.restart();
-        spawnObstacles(level);
-        spawnFood(); // Properly place initial food
-        moveClock.restart();
+    // Once per played game (not replays), before saveReplay() ends the recording
+    auto recordStats = [&]() {
+        if (watching || !recorder.active()) return;
+        GameRecord g;
+        g.seed = gameSeed;
+        g.endedAt = static_cast<int64_t>(std::time(nullptr));
+        g.score = static_cast<uint32_t>(sim.score());
+        g.ticks = static_cast<uint32_t>(sim.tick());
+        g.columns = static_cast<uint16_t>(sim.columns());
+        g.rows = static_cast<uint16_t>(sim.rows());
+        g.startingLevel = static_cast<uint8_t>(startingLevel);
+        g.finalLevel = static_cast<uint8_t>(sim.level());
+        g.assisted = assisted;
+        stats.recordGame(g);
+        };
+    auto saveReplay = [&]() {
+        if (!recorder.active()) return;
+        recorder.finish(sim.score());
+        if (!recorder.save(LAST_REPLAY_FILE)) {
+            std::cerr << "Warning: could not write " << LAST_REPLAY_FILE << "\n";
+        }
         };
 
     GameState state = MainMenu;
+    if (!replayPath.empty()) {
+        startReplay();
+        state = Playing;
+    }
+    else if (hostPort > 0 || !joinAddress.empty()) {
+        if (!startVersus()) {
+            std::cerr << "Error: could not " << (joinAddress.empty() ? "listen on port " : "reach ")
+                      << (joinAddress.empty() ? std::to_string(hostPort) : joinAddress) << "\n";
+            return EXIT_FAILURE;
+        }
+        state = Playing;
+    }
+
+    // Cold start: process start to window, first (loading) frame, assets
+    // decoded (worker time in brackets), stats read and the UI built
+    std::printf("startup: window %.1f ms, first frame %.1f ms, assets %.1f ms (%.1f ms from %s), "
+                "stats %.0f us, ui %.1f ms\n",
+                windowMs, firstFrameMs < 0.0 ? assetsMs : firstFrameMs, assetsMs, loader.loadMs(),
+                loader.fromPack() ? ASSET_PACK_FILE : "loose files", stats.loadMicros(), msSinceStart());
 
     // 7) Main loop
+    double loopWall = msSinceStart() / 1000.0;
+    double loopCpu = processCpuSeconds();
     while (window.isOpen()) {
+        profiler.endFrame();
+        if (exporting && shown == GameOver) break;   // the replay's last frame is out
+
+        // Nothing can change on a menu, pause or game-over screen without
+        // input, so rather than draw the same frame again, sleep until an
+        // event (or the redraw interval). The profiler overlay updates
+        // every second, so it keeps the loop running while it is shown.
+        const bool onDemand = state != Playing && !showProfile && !video.active();
+        std::optional<sf::Event> woken;
+        if (onDemand && !redraw && state == shown) {
+            woken = window.waitEvent(IDLE_REDRAW_INTERVAL);
+            redraw = !woken;
+            frameClock.restart();   // the wait is not frame time
+        }
+        const double nowWall = msSinceStart() / 1000.0;
+        const double nowCpu = processCpuSeconds();
+        if (onDemand) {
+            onDemandSeconds += nowWall - loopWall;
+            onDemandCpu += nowCpu - loopCpu;
+        }
+        loopWall = nowWall;
+        loopCpu = nowCpu;
+
+        profiler.beginFrame();
+        float frameSeconds = frameClock.restart().asSeconds();
+        if (frameStats.endFrame(frameSeconds)) {
+            static const char* pacingNames[] = { "60 FPS cap", "vsync", "uncapped" };
+            input.summarizeLatency();
+            char buf[192];
+            std::snprintf(buf, sizeof(buf),
+                "%.2f ms avg  %.2f ms max  %u draws  %.1f allocs/frame  [%s]\n"
+                "input-to-move %.1f ms avg  %.1f ms max",
+                frameStats.avgFrameMs, frameStats.maxFrameMs, frameStats.avgDrawCalls,
+                frameStats.avgAllocs, pacingNames[pacing],
+                input.avgLatencyMs, input.maxLatencyMs);
+            statsText.setString(buf);
+
+            profiler.summarize();
+            char pbuf[384];
+            int n = std::snprintf(pbuf, sizeof(pbuf),
+                "frame p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms%s\n",
+                profiler.p50FrameMs, profiler.p95FrameMs, profiler.p99FrameMs,
+                profiler.maxFrameMs, profiler.isCapturing() ? "  [capturing]" : "");
+            for (int z = 0; z < ZONE_COUNT && n > 0 && n < int(sizeof(pbuf)); ++z) {
+                n += std::snprintf(pbuf + n, sizeof(pbuf) - n, "%-10s %6.3f ms\n",
+                    zoneName(ProfileZone(z)), profiler.avgZoneMs[z]);
+            }
+            profileText.setString(pbuf);
+        }
+        frameStats.beginFrame();
+        if (exporting) frameSeconds = 1.f / float(videoFps);   // the sim follows video time
+
         // ─── Event handling (SFML 3) ─────────────────────────────────────────
-        while (auto event = window.pollEvent()) {
+        const int64_t eventsStart = profiler.now();
+        for (auto event = woken ? std::move(woken) : window.pollEvent(); event; event = window.pollEvent()) {
             if (event->is<sf::Event::Closed>()) {
                 window.close();
             }
+            // Nothing reacts to the pointer until it clicks
+            if (!event->is<sf::Event::MouseMoved>()) redraw = true;
 
             if (state == MainMenu && event->is<sf::Event::MouseButtonPressed>()) {
                 auto& mpe = *event->getIf<sf::Event::MouseButtonPressed>();
                 if (mpe.button == sf::Mouse::Button::Left) {
                     auto mpos = sf::Mouse::getPosition(window);
                     if (playButton.contains(mpos)) {
+                        autopilotOn = false;
                         state = LevelSelect;
                     }
+                    else if (demoButton.contains(mpos)) {
+                        // Attract mode: the autopilot plays a level 1 game
+                        autopilot.setMode(Autopilot::PathToFood);
+                        autopilotOn = true;
+                        startingLevel = 1;
+                        startGame();
+                        state = Playing;
+                    }
+                    else if (arenaButton.contains(mpos)) {
+                        startArena();
+                        state = Playing;
+                    }
                     else if (exitButton.contains(mpos)) {
                         window.close();
                     }
@@ -352,10 +693,14 @@ int main() {
                 if (mpe.button == sf::Mouse::Button::Left) {
                     auto mpos = sf::Mouse::getPosition(window);
                     if (retryButton.contains(mpos)) {
-                        startGame();
                         state = Playing;
+                        if (versusOn) { if (!startVersus()) state = MainMenu; }
+                        else if (arenaOn) startArena();
+                        else if (watching) startReplay();
+                        else startGame();
                     }
                     else if (menuButton.contains(mpos)) {
+                        if (versusOn) leaveVersus();
                         state = MainMenu;
                     }
                     else if (exitButtonGameOver.contains(mpos)) {
@@ -368,20 +713,85 @@ int main() {
                 auto& kpe = *event->getIf<sf::Event::KeyPressed>();
                 switch (kpe.scancode) {
                 case sf::Keyboard::Scancode::W:
-                case sf::Keyboard::Scancode::Up:    if (dir != Down)  dir = Up;    break;
+                case sf::Keyboard::Scancode::Up:    input.push(Up);    break;
                 case sf::Keyboard::Scancode::S:
-                case sf::Keyboard::Scancode::Down:  if (dir != Up)    dir = Down;  break;
+                case sf::Keyboard::Scancode::Down:  input.push(Down);  break;
                 case sf::Keyboard::Scancode::A:
-                case sf::Keyboard::Scancode::Left:  if (dir != Right) dir = Left;  break;
+                case sf::Keyboard::Scancode::Left:  input.push(Left);  break;
                 case sf::Keyboard::Scancode::D:
-                case sf::Keyboard::Scancode::Right: if (dir != Left)  dir = Right; break;
+                case sf::Keyboard::Scancode::Right: input.push(Right); break;
+                case sf::Keyboard::Scancode::F1:
+                    showStats = !showStats;
+                    break;
+                case sf::Keyboard::Scancode::F2:
+                    pacing = FramePacing((pacing + 1) % 3);
+                    applyPacing();
+                    break;
+                case sf::Keyboard::Scancode::F3:
+                    showProfile = !showProfile;
+                    break;
+                case sf::Keyboard::Scancode::F4:
+                    if (!profiler.isCapturing()) {
+                        profiler.startCapture();
+                    }
+                    else {
+                        profiler.stopCapture();
+                        if (profiler.writeTrace(TRACE_FILE)) {
+                            std::cout << "Wrote " << profiler.capturedEvents()
+                                      << " trace events to " << TRACE_FILE << "\n";
+                        }
+                        else {
+                            std::cerr << "Warning: could not write " << TRACE_FILE << "\n";
+                        }
+                    }
+                    break;
+                case sf::Keyboard::Scancode::T:       // autopilot off / A* / Hamiltonian
+                    if (watching || arenaOn) break;
+                    if (!autopilotOn) {
+                        autopilot.setMode(Autopilot::PathToFood);
+                        autopilotOn = true;
+                    }
+                    else if (autopilot.mode() == Autopilot::PathToFood) {
+                        autopilot.setMode(Autopilot::HamiltonianCycle);
+                    }
+                    else {
+                        autopilotOn = false;
+                    }
+                    autopilot.forget();
+                    assisted = assisted || autopilotOn;
+                    input.clear();
+                    break;
+                case sf::Keyboard::Scancode::Equal:   // replay speed x2
+                    replaySpeed = std::min(replaySpeed * 2.f, 256.f);
+                    break;
+                case sf::Keyboard::Scancode::Hyphen:  // replay speed /2
+                    replaySpeed = std::max(replaySpeed / 2.f, 0.125f);
+                    break;
                 case sf::Keyboard::Scancode::P:
+                    if (versusOn) break;                // the other player can't be paused
                     if (state == Playing) { state = Paused; }
                     else { state = Playing; }
                     break;
+                case sf::Keyboard::Scancode::Backspace:
+                    if (watching || arenaOn) break;
+                    if (history.rewind(sim, size_t(std::ceil(REWIND_SECONDS / sim.moveDelay())))) afterRestore();
+                    break;
+                case sf::Keyboard::Scancode::R:
+                    if (state != Paused || watching || arenaOn) break;
+                    if (history.restartLevel(sim)) {
+                        afterRestore();
+                        state = Playing;
+                    }
+                    break;
                 case sf::Keyboard::Scancode::M:
-                    if (state == Paused) {
-                        if (score > highScore) highScore = score;
+                    if (versusOn) {
+                        leaveVersus();
+                        state = MainMenu;
+                    }
+                    else if (state == Paused) {
+                        recordStats();
+                        saveReplay();
+                        watching = false;
                         state = MainMenu;
                     }
                     break;
@@ -389,271 +799,377 @@ int main() {
                 }
             }
         } // ── end event handling ─────────────────────────────────────────────
+        profiler.lap(ZoneEvents, eventsStart);
+        if (!window.isOpen()) break;
+
+        // Woken by something that changed nothing on screen
+        if (onDemand && !redraw && state == shown) continue;
+        drawing = state;
 
         // ─── MainMenu ─────────────────────────────────────────────────────────
         if (state == MainMenu) {
-            window.clear(sf::Color::Green);
-            highScoreText.setString("High Score: " + std::to_string(highScore));
-            centerText(highScoreText, WINDOW_WIDTH / 2.f, 160.f);
-            window.draw(titleText);
-            window.draw(highScoreText);
-            window.draw(playButton.box);
-            window.draw(playButton.label);
-            window.draw(exitButton.box);
-            window.draw(exitButton.label);
-            window.display();
+            screen.clear(sf::Color::Green);
+            highScoreText.setValues("High Score: %d    Games: %d", int(stats.bestScore()),
+                                    int(stats.state().games));
+            draw(titleText);
+            draw(highScoreText.text());
+            draw(playButton.box);
+            draw(playButton.label);
+            draw(demoButton.box);
+            draw(demoButton.label);
+            draw(arenaButton.box);
+            draw(arenaButton.label);
+            draw(exitButton.box);
+            draw(exitButton.label);
+            present();
             continue;
         }
 
         // ─── LevelSelect ─────────────────────────────────────────────────────
         if (state == LevelSelect) {
-            window.clear(sf::Color::Green);
-            sf::Text ls(font, "Select Level", 40);
-            ls.setFillColor(sf::Color::Black);
-            centerText(ls, WINDOW_WIDTH / 2.f, 100.f);
-            window.draw(ls);
+            screen.clear(sf::Color::Green);
+            draw(levelSelectText);
             for (auto& b : levelButtons) {
-                window.draw(b.box);
-                window.draw(b.label);
+                draw(b.box);
+                draw(b.label);
             }
-            window.draw(backButton.box);
-            window.draw(backButton.label);
-            window.display();
+            draw(backButton.box);
+            draw(backButton.label);
+            present();
             continue;
         }
 
         // ─── GameOver ────────────────────────────────────────────────────────
         if (state == GameOver) {
-            window.clear(sf::Color(0, 100, 0)); // Dark green background
-
-            finalScoreText.setString("Score: " + std::to_string(score));
-            gameOverHighScoreText.setString("High Score: " + std::to_string(highScore));
-            centerText(finalScoreText, WINDOW_WIDTH / 2.f, 180.f);
-            centerText(gameOverHighScoreText, WINDOW_WIDTH / 2.f, 220.f);
-
-            window.draw(gameOverTitle);
-            window.draw(finalScoreText);
-            window.draw(gameOverHighScoreText);
-            window.draw(retryButton.box);
-            window.draw(retryButton.label);
-            window.draw(menuButton.box);
-            window.draw(menuButton.label);
-            window.draw(exitButtonGameOver.box);
-            window.draw(exitButtonGameOver.label);
+            screen.clear(sf::Color(0, 100, 0)); // Dark green background
+
+            if (versusOn) {
+                const ArenaSim& board = versus.sim();
+                const int me = versus.localAgent();
+                finalScoreText.setValues("Score: %d - %d", int(board.score(me)),
+                                         int(board.score(versus.remoteAgent())));
+                gameOverHighScoreText.setValues(versusLoser < 0     ? "Connection lost"
+                                                : versusLoser == 2  ? "Draw"
+                                                : versusLoser == me ? "You lose" : "You win", 0);
+            }
+            else if (arenaOn) {
+                finalScoreText.setValues("Score: %d", int(arena.score(0)));
+                gameOverHighScoreText.setValues("Rank: %d of %d", arenaRank(), arena.agentCount());
+            }
+            else {
+                finalScoreText.setValues("Score: %d", sim.score());
+                gameOverHighScoreText.setValues("High Score (level %d): %d", startingLevel,
+                                                int(stats.bestScore(startingLevel)));
+            }
 
-            window.display();
+            draw(gameOverTitle);
+            draw(finalScoreText.text());
+            draw(gameOverHighScoreText.text());
+            draw(retryButton.box);
+            draw(retryButton.label);
+            draw(menuButton.box);
+            draw(menuButton.label);
+            draw(exitButtonGameOver.box);
+            draw(exitButtonGameOver.label);
+
+            present();
             continue;
         }
 
-        // ─── Playing ─────────────────────────────────────────────────────────
-        if (state == Playing) {
-            // ── Movement & collision ──────────────────────────────────────
-            if (dir != None && moveClock.getElapsedTime().asSeconds() > moveDelay) {
-                moveClock.restart();
-
-                // 1) Advance head
-                sf::Vector2f head = snake.front();
-                switch (dir) {
-                case Up:    head.y -= BLOCK_SIZE; break;
-                case Down:  head.y += BLOCK_SIZE; break;
-                case Left:  head.x -= BLOCK_SIZE; break;
-                case Right: head.x += BLOCK_SIZE; break;
-                default:    break;
-                }
-
-                // 2) Convert to grid cell
-                sf::Vector2u cell{
-                    static_cast<unsigned>(head.x / BLOCK_SIZE),
-                    static_cast<unsigned>(head.y / BLOCK_SIZE)
-                };
-
-                // 3) Border collision check
-                bool borderCollision = false;
-                if (cell.x == 0 || cell.x == COLUMNS - 1 ||
-                    cell.y == 0 || cell.y == ROWS - 1) {
-                    borderCollision = true;
+        // ─── Arena ───────────────────────────────────────────────────────────
+        if (state == Playing && arenaOn) {
+            // Same fixed timestep as a normal game; the bots decide and the
+            // arena moves every snake at once. In versus the session ticks
+            // instead, and draws from its (partly predicted) arena.
+            int64_t zoneStart = profiler.now();
+            const ArenaSim& board = versusOn ? versus.sim() : arena;
+            const int me = versusOn ? versus.localAgent() : 0;
+            if (versusOn) {
+                versus.poll();
+                if (versus.status() == NetConnecting) {
+                    screen.clear(sf::Color::Green);
+                    infoText.setValues(joinAddress.empty() ? "Versus    waiting for a player on port %d"
+                                                           : "Versus    connecting to the host...",
+                                       int(versus.localPort()));
+                    draw(infoText.text());
+                    present();
+                    continue;
                 }
+            }
 
-                // 4) Eat food?
-                if (cell == foodCell) {
-                    eatSound.play();
-                    score += 10;
-                    spawnFood(); // Respawn food in valid location
+            tickAccumulator += std::min(frameSeconds, MAX_FRAME_TIME);
+            int ticksThisFrame = 0;
+            while (state == Playing && tickAccumulator >= ARENA_MOVE_DELAY &&
+                   ticksThisFrame < MAX_TICKS_PER_FRAME)
+            {
+                tickAccumulator -= ARENA_MOVE_DELAY;
+                ++ticksThisFrame;
+
+                if (versusOn) {
+                    // A tick the session has to wait out keeps the turn for the next one
+                    if (versusTurn == None && board.alive(me)) versusTurn = input.nextTurn(versus.plannedHeading());
+                    if (!versus.advance(versusTurn)) continue;
+                    versusTurn = None;
                 }
                 else {
-                    snake.pop_back();
-                }
-
-                // 5) Bonus spawn / expire / eat
-                if (!bonusActive &&
-                    bonusSpawnClock.getElapsedTime().asSeconds() > BONUS_SPAWN_INTERVAL)
-                {
-                    // Find valid bonus location
-                    std::vector<sf::Vector2u> freeCells;
-                    for (unsigned y = 1; y < ROWS - 1; ++y) {
-                        for (unsigned x = 1; x < COLUMNS - 1; ++x) {
-                            sf::Vector2u candidate(x, y);
-                            if (isCellFree(candidate) && candidate != foodCell) {
-                                freeCells.push_back(candidate);
-                            }
-                        }
+                    arenaInputs[0] = arena.alive(0) ? input.nextTurn(arena.heading(0)) : None;
+                    for (int i = 1; i < arena.agentCount(); ++i) {
+                        arenaInputs[i] = arena.alive(i) ? arenaBot(arena, i, arenaBots) : None;
                     }
+                    arena.step(arenaInputs);
+                }
 
-                    if (!freeCells.empty()) {
-                        bonusActive = true;
-                        bonusCell = freeCells[std::rand() % freeCells.size()];
-                        bonusLiveClock.restart();
+                const unsigned ev = board.events(me);
+                if (ev & ArenaEvAte) mixer.play(SfxEat);
+                if (ev & ArenaEvDied) {
+                    input.clear();
+                    if (!versusOn && --arenaLives == 0) {
+                        mixer.play(SfxGameOver);
+                        state = GameOver;
                     }
                 }
-                if (bonusActive &&
-                    bonusLiveClock.getElapsedTime().asSeconds() > BONUS_DURATION)
-                {
-                    bonusActive = false;
-                    bonusSpawnClock.restart();
-                }
-                if (bonusActive && cell == bonusCell) {
-                    eatSound.play(); // Same sound as regular food
-                    score += 50;
-                    bonusActive = false;
-                    bonusSpawnClock.restart();
+            }
+            if (ticksThisFrame == MAX_TICKS_PER_FRAME) {
+                tickAccumulator = std::min(tickAccumulator, ARENA_MOVE_DELAY);
+            }
+            // A versus match ends on ticks both players have confirmed, so
+            // both see the same result
+            if (versusOn) {
+                versusLoser = versus.loser(INITIAL_LIVES);
+                if (versusLoser >= 0 || versus.status() == NetDisconnected) {
+                    versus.finish();
+                    mixer.play(SfxGameOver);
+                    state = GameOver;
                 }
+            }
 
-                // 6) Level progression
-                if (score >= nextLevelScore) {
-                    level++;
-                    nextLevelScore += 100;
-                    moveDelay *= 0.9f;
-                    spawnObstacles(level);
-
-                    // Ensure food is still in valid location
-                    if (!isCellFree(foodCell)) {
-                        spawnFood();
+            zoneStart = profiler.lap(ZoneSim, zoneStart);
+            mixer.update();
+            zoneStart = profiler.lap(ZoneAudio, zoneStart);
+
+            screen.clear(sf::Color::White);
+            const float half = cellSize / 2.f;
+            const Cell focus = board.head(me);  // where the player is, or last was
+            sf::View camera = boardCamera({ focus.x * cellSize + half, focus.y * cellSize + half },
+                { float(WINDOW_WIDTH), float(WINDOW_HEIGHT) },
+                { board.columns() * cellSize, board.rows() * cellSize });
+            const CellRange visible = visibleCells(camera, unsigned(board.columns()),
+                                                   unsigned(board.rows()), cellSize);
+            screen.setView(camera);
+
+            background.update(unsigned(board.columns()), unsigned(board.rows()), cellSize, visible);
+            background.draw(screen);
+            ++frameStats.drawCalls;
+            zoneStart = profiler.lap(ZoneBackground, zoneStart);
+
+            // Snakes and food straight from the grid, for the cells in view
+            // only: hundreds of snakes cost what the window shows
+            entities.clear();
+            for (int y = visible.y0; y < visible.y1; ++y) {
+                for (int x = visible.x0; x < visible.x1; ++x) {
+                    const ArenaCell kind = board.cellAt({ x, y });
+                    if (kind != ArenaFood && kind != ArenaBody) continue;
+                    const sf::Vector2f center{ x * cellSize + half, y * cellSize + half };
+                    if (kind == ArenaFood) {
+                        entities.addCircle(center, half, sf::Color::White);
+                        continue;
                     }
+                    const int who = board.ownerAt({ x, y });
+                    const bool isHead = board.head(who) == Cell{ x, y };
+                    sf::Color color = who == me ? sf::Color(128, 0, 128)
+                                                : ARENA_BOT_COLORS[who % ARENA_BOT_COLOR_COUNT];
+                    if (isHead) color = who == me ? sf::Color(255, 0, 255) : sf::Color::Black;
+                    entities.addCircle(center, half, color);
                 }
+            }
+            entities.draw(screen);
+            ++frameStats.drawCalls;
+            screen.setView(screen.getDefaultView());
+            zoneStart = profiler.lap(ZoneEntities, zoneStart);
+
+            if (versusOn) {
+                infoText.setValues(versus.desynced() ? "Versus (out of sync)    Lives: %d    Score: %d - %d"
+                                                     : "Versus    Lives: %d    Score: %d - %d",
+                    std::max(INITIAL_LIVES - int(board.deaths(me)), 0), int(board.score(me)),
+                    int(board.score(versus.remoteAgent())));
+            }
+            else {
+                infoText.setValues("Arena    Lives: %d    Score: %d    Rank: %d",
+                    arenaLives, int(arena.score(0)), arenaRank());
+            }
+            draw(infoText.text());
+            if (showStats) draw(statsText);
+            profiler.lap(ZoneHud, zoneStart);
 
-                // 7) Insert new head only if no border collision
-                if (!borderCollision) {
-                    snake.insert(snake.begin(), head);
-                }
+            present();
+            continue;
+        }
 
-                // 8) Collision with obstacle or self?
-                bool died = false;
-                if (borderCollision) {
-                    died = true;
+        // ─── Playing ─────────────────────────────────────────────────────────
+        if (state == Playing) {
+            // ── Movement & collision (fixed timestep) ─────────────────────
+            // Real time accumulates and is consumed in whole moveDelay ticks,
+            // so tick spacing doesn't depend on the frame rate. Several ticks
+            // can run in one frame when a frame is long or moveDelay is short.
+            // A replay runs the same loop with scaled time and a scaled cap.
+            int64_t zoneStart = profiler.now();
+            const float speed = watching ? replaySpeed : 1.f;
+            const int   maxTicks = MAX_TICKS_PER_FRAME * int(std::ceil(speed));
+            tickAccumulator += std::min(frameSeconds, MAX_FRAME_TIME) * speed;
+            int ticksThisFrame = 0;
+            while (state == Playing && tickAccumulator >= sim.moveDelay() &&
+                   ticksThisFrame < maxTicks)
+            {
+                tickAccumulator -= sim.moveDelay();
+                ++ticksThisFrame;
+
+                Direction turn;
+                if (watching) {
+                    turn = replay.next();
                 }
                 else {
-                    for (auto& o : obstacles) {
-                        if (cell == o) { died = true; break; }
+                    // Autopilot turns go through the recorder like key presses
+                    if (autopilotOn) {
+                        input.clear();
+                        turn = autopilot.next(sim);
                     }
-                    if (!died) {
-                        for (size_t i = 1; i < snake.size(); ++i) {
-                            if (snake[i] == snake[0]) { died = true; break; }
-                        }
+                    else {
+                        turn = input.nextTurn(sim.heading());
                     }
+                    recorder.record(turn);
+                }
+                unsigned ev = sim.step(turn);
+                interpolate = (ev & EvMoved) != 0;
+                history.afterStep(sim, ev);
+                if (watching) {
+                    for (uint64_t to; replay.restorePending(to);) history.restore(sim, to);
                 }
 
-                if (died) {
-                    lives--;
-                    if (lives > 0) {
-                        // Reset snake position
-                        snake.clear();
-                        snake.push_back({ WINDOW_WIDTH / 2.f, WINDOW_HEIGHT / 2.f });
-                        dir = None;
-                    }
-                    else {
-                        gameOverSound.play();
-                        if (score > highScore) highScore = score;
-                        state = GameOver;
-                    }
+                if (ev & EvAteFood)  mixer.play(SfxEat);
+                if (ev & EvAteBonus) mixer.play(SfxBonus);
+                if (ev & EvLostLife) {
+                    input.clear();   // don't carry turns into the respawned snake
+                }
+                if (ev & EvGameOver) {
+                    mixer.play(SfxGameOver);
+                    recordStats();
+                    saveReplay();
+                    state = GameOver;
                 }
+                else if (watching && replay.finished()) {
+                    // Recording was stopped from the pause menu
+                    state = GameOver;
+                }
+            }
+            if (ticksThisFrame == maxTicks) {
+                tickAccumulator = std::min(tickAccumulator, sim.moveDelay());
             }
 
+            zoneStart = profiler.lap(ZoneSim, zoneStart);
+            mixer.update();
+            zoneStart = profiler.lap(ZoneAudio, zoneStart);
+
+            // Fraction of the way from the previous tick to the next one
+            float alpha = interpolate ? std::min(tickAccumulator / sim.moveDelay(), 1.f) : 1.f;
+
             // ── Drawing ───────────────────────────────────────────────────
-            window.clear(sf::Color::White);
-
-            // Checkerboard
-            for (unsigned r = 0; r < ROWS; ++r) {
-                for (unsigned c = 0; c < COLUMNS; ++c) {
-                    sf::RectangleShape cell;
-                    cell.setSize({ BLOCK_SIZE, BLOCK_SIZE });
-                    cell.setPosition({ c * BLOCK_SIZE, r * BLOCK_SIZE });
-                    cell.setFillColor(((r + c) % 2 == 0) ? BG_COLOR1 : BG_COLOR2);
-                    window.draw(cell);
-                }
-            }
+            screen.clear(sf::Color::White);
 
-            // Food
-            {
-                sf::CircleShape food(BLOCK_SIZE / 2.f);
-                food.setFillColor(sf::Color::White);
-                food.setOrigin({ BLOCK_SIZE / 2.f, BLOCK_SIZE / 2.f });
-                food.setPosition({
-                    foodCell.x * BLOCK_SIZE + BLOCK_SIZE / 2.f,
-                    foodCell.y * BLOCK_SIZE + BLOCK_SIZE / 2.f
-                    });
-                window.draw(food);
-            }
+            const float half = cellSize / 2.f;
+            auto cellCenter = [&](const Cell& c) {
+                return sf::Vector2f{ c.x * cellSize + half, c.y * cellSize + half };
+                };
+            auto lerpCenter = [&](const Cell& from, const Cell& to) {
+                sf::Vector2f a = cellCenter(from);
+                sf::Vector2f b = cellCenter(to);
+                return a + (b - a) * alpha;
+                };
 
-            // Bonus
-            if (bonusActive) {
-                sf::CircleShape bonus(BLOCK_SIZE / 2.f);
-                bonus.setFillColor(BONUS_COLOR);
-                bonus.setOrigin({ BLOCK_SIZE / 2.f, BLOCK_SIZE / 2.f });
-                bonus.setPosition({
-                    bonusCell.x * BLOCK_SIZE + BLOCK_SIZE / 2.f,
-                    bonusCell.y * BLOCK_SIZE + BLOCK_SIZE / 2.f
-                    });
-                window.draw(bonus);
+            // The camera follows the (interpolated) head; everything outside
+            // its view is skipped, so big boards cost what the window shows
+            const auto& snake = sim.body();
+            const Cell neck = snake.size() > 1 ? snake[1] : sim.previousTail();
+            sf::View camera = boardCamera(lerpCenter(neck, snake.front()),
+                { float(WINDOW_WIDTH), float(WINDOW_HEIGHT) },
+                { sim.columns() * cellSize, sim.rows() * cellSize });
+            const CellRange visible = visibleCells(camera, unsigned(sim.columns()),
+                                                   unsigned(sim.rows()), cellSize);
+            screen.setView(camera);
+
+            // Checkerboard + borders (single cached vertex array)
+            background.update(unsigned(sim.columns()), unsigned(sim.rows()), cellSize, visible);
+            background.draw(screen);
+            ++frameStats.drawCalls;
+            zoneStart = profiler.lap(ZoneBackground, zoneStart);
+
+            // Food, bonus, obstacles and snake: one batched draw call
+            entities.clear();
+            if (visible.contains(sim.foodCell().x, sim.foodCell().y)) {
+                entities.addCircle(cellCenter(sim.foodCell()), half, sf::Color::White);
             }
-
-            // Obstacles
-            for (auto& o : obstacles) {
-                sf::RectangleShape obs;
-                obs.setSize({ BLOCK_SIZE - 2.f, BLOCK_SIZE - 2.f });
-                obs.setFillColor(OBSTACLE_COLOR);
-                obs.setPosition({ o.x * BLOCK_SIZE + 1.f, o.y * BLOCK_SIZE + 1.f });
-                window.draw(obs);
+            if (sim.bonusActive() && visible.contains(sim.bonusCell().x, sim.bonusCell().y)) {
+                entities.addCircle(cellCenter(sim.bonusCell()), half, BONUS_COLOR);
             }
-
-            // Snake
-            for (size_t i = 0; i < snake.size(); ++i) {
-                sf::CircleShape part(BLOCK_SIZE / 2.f);
-                part.setOrigin({ BLOCK_SIZE / 2.f, BLOCK_SIZE / 2.f });
-                part.setPosition({ snake[i].x + BLOCK_SIZE / 2.f,
-                                   snake[i].y + BLOCK_SIZE / 2.f });
-                if (i == 0) {
-                    int tint = (level * 5) % 256;
-                    part.setFillColor({ static_cast<uint8_t>((255 + tint) % 256), 0, 255 });
-                }
-                else {
-                    part.setFillColor({ 128, 0, 128 });
-                }
-                window.draw(part);
+            for (auto& o : sim.obstacleCells()) {
+                if (!visible.contains(o.x, o.y)) continue;
+                entities.addRect({ o.x * cellSize + 1.f, o.y * cellSize + 1.f },
+                                 { cellSize - 2.f, cellSize - 2.f }, OBSTACLE_COLOR);
             }
 
-            // Borders
-            window.draw(borderTop);
-            window.draw(borderBottom);
-            window.draw(borderLeft);
-            window.draw(borderRight);
+            int tint = (sim.level() * 5) % 256;
+            const sf::Color headColor{ static_cast<uint8_t>((255 + tint) % 256), 0, 255 };
+            const sf::Color bodyColor{ 128, 0, 128 };
+            for (size_t i = snake.size(); i-- > 0; ) {   // tail first so the head is on top
+                Cell prev = (i + 1 < snake.size()) ? snake[i + 1] : sim.previousTail();
+                if (!visible.contains(snake[i].x, snake[i].y) && !visible.contains(prev.x, prev.y)) continue;
+                entities.addCircle(lerpCenter(prev, snake[i]), half, i == 0 ? headColor : bodyColor);
+            }
+            entities.draw(screen);
+            ++frameStats.drawCalls;
+            screen.setView(screen.getDefaultView());
+            zoneStart = profiler.lap(ZoneEntities, zoneStart);
 
             // Info text
-            infoText.setString(
-                "Lives: " + std::to_string(lives) +
-                "    Score: " + std::to_string(score) +
-                "    Level: " + std::to_string(level)
-            );
-            window.draw(infoText);
+            if (watching) {
+                infoText.setValues("Replay %d%%    Score: %d    Level: %d",
+                    int(replaySpeed * 100.f), sim.score(), sim.level());
+            }
+            else if (autopilotOn) {
+                infoText.setValues(autopilot.mode() == Autopilot::PathToFood
+                                       ? "Autopilot (A*)    Lives: %d    Score: %d    Level: %d"
+                                       : "Autopilot (cycle)    Lives: %d    Score: %d    Level: %d",
+                    sim.lives(), sim.score(), sim.level());
+            }
+            else {
+                infoText.setValues("Lives: %d    Score: %d    Level: %d",
+                    sim.lives(), sim.score(), sim.level());
+            }
+            draw(infoText.text());
+            if (showStats) draw(statsText);
+            profiler.lap(ZoneHud, zoneStart);
 
-            window.display();
+            present();
         }
         // ─── Paused ─────────────────────────────────────────────────────────
         else if (state == Paused) {
-            window.clear(sf::Color(0, 0, 0, 150));
-            window.draw(pauseText);
-            window.display();
+            screen.clear(sf::Color(0, 0, 0, 150));
+            draw(pauseText);
+            present();
         }
     }
 
+    if (video.active()) {
+        const bool written = video.finish();
+        std::printf("video: %llu frames (%u fps, %llu captures the writer had no room for), "
+                    "%.1f MB -> %s%s\n",
+                    (unsigned long long)video.framesWritten(), video.fps(),
+                    (unsigned long long)video.framesRefused(), double(video.bytesWritten()) / 1e6,
+                    videoPath.c_str(), written ? "" : " (write failed)");
+    }
+    if (onDemandSeconds > 0.0) {
+        std::printf("menus: %.1f%% CPU over %.1f s, %llu frames drawn\n",
+                    100.0 * onDemandCpu / onDemandSeconds, onDemandSeconds,
+                    (unsigned long long)onDemandFrames);
+    }
     return 0;
-}
\ No newline at end of file
+}
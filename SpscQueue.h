@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer / single-consumer ring buffer.
+// push() may only be called from one thread and pop()/clear() from one
+// (possibly different) thread. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    // Returns false (and drops the value) when the queue is full
+    bool push(const T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity) return false;
+        buf[h & (Capacity - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        out = buf[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: discard everything queued so far
+    void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    bool   empty() const { return size() == 0; }
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> buf{};
+    alignas(64) std::atomic<size_t> head{ 0 };   // next slot to write
+    alignas(64) std::atomic<size_t> tail{ 0 };   // next slot to read
+};
@@ -0,0 +1,316 @@
+﻿#include "StatsStore.h"
+
+#include "SnakeSim.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Encoding
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const size_t GAME_PAYLOAD = 35;
+static const size_t SUMMARY_PAYLOAD = 28 + 4 * STATS_LEVELS;
+static const size_t SESSION_PAYLOAD = 4;
+static const size_t HEADER_SIZE = 5;
+
+static uint32_t crc32(const uint8_t* p, size_t n) {
+    static uint32_t table[256];
+    static const bool built = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)built;
+
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; ++i) c = table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+// Appends one framed record; `payload` is filled by the caller's lambda
+template <typename Fill>
+static void putRecord(std::vector<uint8_t>& out, uint8_t type, Fill fill) {
+    const size_t start = out.size();
+    out.push_back(type);
+    putLe(out, 0, 2);
+    fill(out);
+    const size_t payload = out.size() - start - 3;
+    out[start + 1] = uint8_t(payload);
+    out[start + 2] = uint8_t(payload >> 8);
+    putLe(out, crc32(out.data() + start, out.size() - start), 4);
+}
+
+static void putGame(std::vector<uint8_t>& out, const GameRecord& g) {
+    putLe(out, g.seed, 8);
+    putLe(out, uint64_t(g.endedAt), 8);
+    putLe(out, g.session, 4);
+    putLe(out, g.score, 4);
+    putLe(out, g.ticks, 4);
+    putLe(out, g.columns, 2);
+    putLe(out, g.rows, 2);
+    out.push_back(g.startingLevel);
+    out.push_back(g.finalLevel);
+    out.push_back(g.assisted ? 1 : 0);
+}
+
+static GameRecord readGame(const uint8_t* p) {
+    GameRecord g;
+    g.seed = readLe(p, 8);
+    g.endedAt = int64_t(readLe(p + 8, 8));
+    g.session = uint32_t(readLe(p + 16, 4));
+    g.score = uint32_t(readLe(p + 20, 4));
+    g.ticks = uint32_t(readLe(p + 24, 4));
+    g.columns = uint16_t(readLe(p + 28, 2));
+    g.rows = uint16_t(readLe(p + 30, 2));
+    g.startingLevel = p[32];
+    g.finalLevel = p[33];
+    g.assisted = (p[34] & 1) != 0;
+    return g;
+}
+
+static void putHeader(std::vector<uint8_t>& out) {
+    for (char c : { 'S', 'N', 'K', 'S' }) out.push_back(uint8_t(c));
+    out.push_back(STATS_VERSION);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// File helpers
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Flushes stdio's buffer and asks the OS to put the bytes on disk
+static bool syncFile(std::FILE* f) {
+    if (std::fflush(f) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Atomically replaces `to` with `from`
+static bool replaceFile(const std::string& from, const std::string& to) {
+#if defined(_WIN32)
+    return MoveFileExA(from.c_str(), to.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// StatsState
+// ─────────────────────────────────────────────────────────────────────────────
+
+void StatsState::apply(const GameRecord& g) {
+    ++games;
+    totalScore += g.score;
+    totalTicks += g.ticks;
+    const bool ranked = !g.assisted && g.columns == DEFAULT_COLUMNS && g.rows == DEFAULT_ROWS &&
+                        g.startingLevel >= 1 && g.startingLevel <= STATS_LEVELS;
+    if (ranked) best[g.startingLevel] = std::max(best[g.startingLevel], g.score);
+    remember(g);
+}
+
+void StatsState::remember(const GameRecord& g) {
+    history.push_back(g);
+    if (history.size() > HISTORY) history.pop_front();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// StatsStore
+// ─────────────────────────────────────────────────────────────────────────────
+
+StatsStore::StatsStore(std::string path)
+    : path(std::move(path))
+{
+}
+
+StatsStore::~StatsStore() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+bool StatsStore::load() {
+    auto t0 = std::chrono::steady_clock::now();
+    mine = StatsState();
+    damaged = false;
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> bytes;
+    if (in) bytes.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    const uint8_t* p = bytes.data();
+    const size_t size = bytes.size();
+    bool valid = size >= HEADER_SIZE && p[0] == 'S' && p[1] == 'N' && p[2] == 'K' && p[3] == 'S' &&
+                 p[4] == STATS_VERSION;
+    size_t at = HEADER_SIZE;
+    while (valid && at < size) {
+        // Anything short, unknown or failing its checksum ends the log
+        if (at + 7 > size) { valid = false; break; }
+        const uint8_t type = p[at];
+        const size_t payload = size_t(readLe(p + at + 1, 2));
+        if (at + 7 + payload > size ||
+            crc32(p + at, 3 + payload) != uint32_t(readLe(p + at + 3 + payload, 4))) {
+            valid = false;
+            break;
+        }
+        const uint8_t* body = p + at + 3;
+        if ((type == RecordGame || type == RecordHistory) && payload == GAME_PAYLOAD) {
+            if (type == RecordGame) mine.apply(readGame(body));
+            else mine.remember(readGame(body));
+        }
+        else if (type == RecordSummary && payload == SUMMARY_PAYLOAD) {
+            mine.sessions = uint32_t(readLe(body, 4));
+            mine.games = readLe(body + 4, 8);
+            mine.totalScore = readLe(body + 12, 8);
+            mine.totalTicks = readLe(body + 20, 8);
+            for (int l = 1; l <= STATS_LEVELS; ++l) mine.best[l] = uint32_t(readLe(body + 24 + 4 * l, 4));
+            mine.history.clear();
+        }
+        else if (type == RecordSession && payload == SESSION_PAYLOAD) {
+            mine.sessions = std::max(mine.sessions, uint32_t(readLe(body, 4)));
+        }
+        else {
+            valid = false;
+            break;
+        }
+        at += 7 + payload;
+    }
+
+    // A missing file is not damage; a bad header or tail is
+    damaged = !bytes.empty() && !valid;
+    loadUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    return !damaged;
+}
+
+void StatsStore::start() {
+    if (worker.joinable()) return;
+    ++mine.sessions;
+    theirs = mine;
+    queue.push_back({ RecordSession, GameRecord() });
+    worker = std::thread(&StatsStore::writerLoop, this);
+}
+
+void StatsStore::recordGame(GameRecord g) {
+    g.session = mine.sessions;
+    mine.apply(g);
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        queue.push_back({ RecordGame, g });
+    }
+    wake.notify_one();
+}
+
+uint32_t StatsStore::bestScore(int startingLevel) const {
+    if (startingLevel < 1 || startingLevel > STATS_LEVELS) return 0;
+    return mine.best[startingLevel];
+}
+
+uint32_t StatsStore::bestScore() const {
+    return *std::max_element(mine.best + 1, mine.best + STATS_LEVELS + 1);
+}
+
+void StatsStore::writerLoop() {
+    // A damaged or foreign log is rewritten from what loaded, before anything
+    // is appended after the bad bytes
+    std::FILE* log = nullptr;
+    if (damaged) compact();
+    else if ((log = std::fopen(path.c_str(), "ab")) && std::fseek(log, 0, SEEK_END) == 0 &&
+             std::ftell(log) == 0) {
+        std::vector<uint8_t> header;
+        putHeader(header);
+        std::fwrite(header.data(), 1, header.size(), log);
+    }
+
+    std::vector<Pending> batch;
+    std::vector<uint8_t> bytes;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> hold(lock);
+            wake.wait(hold, [&] { return stopping || !queue.empty(); });
+            batch.swap(queue);
+            if (batch.empty() && stopping) break;
+        }
+
+        bytes.clear();
+        for (const Pending& r : batch) {
+            if (r.type == RecordSession) {
+                putRecord(bytes, RecordSession, [&](std::vector<uint8_t>& o) { putLe(o, theirs.sessions, 4); });
+            }
+            else {
+                theirs.apply(r.game);
+                putRecord(bytes, RecordGame, [&](std::vector<uint8_t>& o) { putGame(o, r.game); });
+            }
+        }
+        appendsSinceCompact += uint32_t(batch.size());
+        batch.clear();
+
+        // While the log is still damaged (the first rewrite failed) nothing
+        // is appended after the bad bytes; the next rewrite carries it all
+        if (!damaged && !log) log = std::fopen(path.c_str(), "ab");
+        if (log) {
+            std::fwrite(bytes.data(), 1, bytes.size(), log);
+            syncFile(log);
+        }
+
+        if (damaged || appendsSinceCompact >= COMPACT_EVERY) {
+            if (log) std::fclose(log);
+            log = nullptr;
+            compact();
+        }
+    }
+    if (log) std::fclose(log);
+}
+
+bool StatsStore::compact() {
+    std::vector<uint8_t> bytes;
+    putHeader(bytes);
+    putRecord(bytes, RecordSummary, [&](std::vector<uint8_t>& o) {
+        putLe(o, theirs.sessions, 4);
+        putLe(o, theirs.games, 8);
+        putLe(o, theirs.totalScore, 8);
+        putLe(o, theirs.totalTicks, 8);
+        for (int l = 1; l <= STATS_LEVELS; ++l) putLe(o, theirs.best[l], 4);
+    });
+    for (const GameRecord& g : theirs.history) {
+        putRecord(bytes, RecordHistory, [&](std::vector<uint8_t>& o) { putGame(o, g); });
+    }
+
+    const std::string temp = path + ".tmp";
+    std::FILE* f = std::fopen(temp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size() && syncFile(f);
+    ok = std::fclose(f) == 0 && ok;
+    ok = ok && replaceFile(temp, path);
+    if (!ok) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    appendsSinceCompact = 0;
+    damaged = false;
+    return true;
+}
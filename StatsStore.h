@@ -0,0 +1,116 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Persistent stats
+//
+// High scores per starting level, totals and the most recent games, kept in
+// an append-only log of small checksummed records:
+//
+//   "SNKS"  u8 version
+//   record  u8 type  u16 payloadSize  payload  u32 crc32(type, size, payload)
+//
+// Every finished game appends one record. A crash can at worst leave a torn
+// record at the end, which fails its checksum and is ignored (with anything
+// after it). Every COMPACT_EVERY appends the log is rewritten as one summary
+// record plus the recent history, into a temporary file that then replaces
+// the log by atomic rename, so the file on disk is always either the old or
+// the new log.
+//
+// All file writes happen on a background thread; recordGame() only updates
+// memory and queues the record, so saving never stalls a frame.
+// ─────────────────────────────────────────────────────────────────────────────
+
+const uint8_t STATS_VERSION = 1;
+const int     STATS_LEVELS = 5;             // starting levels 1..5
+
+struct GameRecord {
+    uint64_t seed = 0;
+    int64_t  endedAt = 0;                   // unix time
+    uint32_t session = 0;                   // launch number, from 1
+    uint32_t score = 0;
+    uint32_t ticks = 0;
+    uint16_t columns = 0;
+    uint16_t rows = 0;
+    uint8_t  startingLevel = 1;
+    uint8_t  finalLevel = 1;
+    bool     assisted = false;              // the autopilot played part of it
+};
+
+struct StatsState {
+    static const size_t HISTORY = 200;      // recent games kept through compaction
+
+    uint32_t sessions = 0;
+    uint64_t games = 0;
+    uint64_t totalScore = 0;
+    uint64_t totalTicks = 0;
+    uint32_t best[STATS_LEVELS + 1] = {};   // by starting level; best[0] is unused
+    std::deque<GameRecord> history;         // oldest first
+
+    // Counts the game and keeps it in the history. Only unassisted games
+    // on the default board set high scores.
+    void apply(const GameRecord& g);
+    void remember(const GameRecord& g);     // history only (already counted)
+};
+
+class StatsStore {
+public:
+    static const uint32_t COMPACT_EVERY = 256;
+
+    explicit StatsStore(std::string path);
+    ~StatsStore();                          // writes whatever is queued, then joins
+
+    StatsStore(const StatsStore&) = delete;
+    StatsStore& operator=(const StatsStore&) = delete;
+
+    // Reads the log (a missing one is an empty history). Returns false if
+    // it ended in a damaged record: the good prefix is still loaded, and
+    // the log is rewritten from it as soon as the writer starts.
+    bool   load();
+    double loadMicros() const { return loadUs; }
+
+    // Starts a new session and the writer thread
+    void start();
+
+    // Main thread: counts the game now, writes it in the background
+    void recordGame(GameRecord g);
+
+    const StatsState& state() const { return mine; }
+    uint32_t bestScore(int startingLevel) const;
+    uint32_t bestScore() const;             // over all starting levels
+    uint32_t session() const { return mine.sessions; }
+
+private:
+    enum RecordType : uint8_t { RecordSummary = 1, RecordGame = 2, RecordHistory = 3, RecordSession = 4 };
+
+    struct Pending {
+        RecordType type;
+        GameRecord game;
+    };
+
+    void writerLoop();
+    bool compact();                         // writer thread only
+
+    std::string path;
+    StatsState  mine;                       // main thread's view
+    double      loadUs = 0.0;
+    bool        damaged = false;
+
+    // Shared with the writer
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::vector<Pending>    queue;
+    bool                    stopping = false;
+
+    // Writer thread only
+    std::thread worker;
+    StatsState  theirs;                     // the log's contents, for compaction
+    uint32_t    appendsSinceCompact = 0;
+};
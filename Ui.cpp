@@ -0,0 +1,49 @@
+﻿#include "Ui.h"
+
+#include <cstdio>
+
+void centerText(sf::Text& txt, float x, float y) {
+    auto b = txt.getLocalBounds();
+    txt.setOrigin({ b.size.x / 2.f, b.size.y / 2.f });
+    txt.setPosition({ x, y });
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// UiText
+// ─────────────────────────────────────────────────────────────────────────────
+
+UiText::UiText(const sf::Font& font, unsigned charSize, sf::Color color)
+    : txt(font, "", charSize)
+{
+    txt.setFillColor(color);
+}
+
+void UiText::setPosition(sf::Vector2f position) {
+    centered = false;
+    anchor = position;
+    relayout();
+}
+
+void UiText::centerOn(float x, float y) {
+    centered = true;
+    anchor = { x, y };
+    relayout();
+}
+
+void UiText::setValues(const char* format, int a, int b, int c) {
+    if (format == fmt && a == values[0] && b == values[1] && c == values[2]) return;
+    fmt = format;
+    values[0] = a;
+    values[1] = b;
+    values[2] = c;
+
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), format, a, b, c);
+    txt.setString(buf);
+    relayout();
+}
+
+void UiText::relayout() {
+    if (centered) centerText(txt, anchor.x, anchor.y);
+    else          txt.setPosition(anchor);
+}
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <SFML/Graphics.hpp>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Retained UI elements
+//
+// Menu and HUD elements are built once and only re-laid-out when their
+// contents change, so steady-state frames do no string building or glyph
+// layout.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct Button {
+    sf::RectangleShape box;
+    sf::Text           label;
+    Button(const sf::Font& font, const sf::String& str, unsigned charSize)
+        : label(font, str, charSize)
+    {
+    }
+    bool contains(const sf::Vector2i& m) const {
+        return box.getGlobalBounds()
+            .contains(sf::Vector2f{ float(m.x), float(m.y) });
+    }
+};
+
+void centerText(sf::Text& txt, float x, float y);
+
+// Text built from a printf-style format and up to three integers, e.g.
+// "High Score: %d". setValues() is a no-op unless the format or one of the
+// values differs from what is currently shown.
+class UiText {
+public:
+    UiText(const sf::Font& font, unsigned charSize, sf::Color color);
+
+    // Anchor the top-left corner (default) or keep the text centered on a point
+    void setPosition(sf::Vector2f position);
+    void centerOn(float x, float y);
+
+    void setValues(const char* format, int a, int b = 0, int c = 0);
+
+    const sf::Text& text() const { return txt; }
+
+private:
+    void relayout();
+
+    sf::Text     txt;
+    const char*  fmt = nullptr;
+    int          values[3] = { 0, 0, 0 };
+    bool         centered = false;
+    sf::Vector2f anchor;
+};
@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Small helpers shared by the file formats and the network code
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Little-endian integers of `bytes` bytes, as every on-disk and on-wire
+// format here stores them
+inline uint64_t readLe(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+inline void putLe(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(uint8_t(v >> (8 * i)));
+}
+
+// Monotonic microseconds, for timeouts and packet scheduling
+inline int64_t steadyUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
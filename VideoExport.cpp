@@ -0,0 +1,156 @@
+﻿#include "VideoExport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// How long the writer sleeps when the ring is empty, and the main thread
+// when it is full and told to wait. Either side only ever waits for the
+// other to move a counter, so a short sleep stands in for a wake-up.
+static const std::chrono::microseconds IDLE_SLEEP(500);
+
+VideoWriter::~VideoWriter() {
+    finish();
+}
+
+bool VideoWriter::start(const std::string& path, unsigned width, unsigned height, unsigned fps) {
+    finish();
+    if (width == 0 || height == 0 || fps == 0) return false;
+    w = width;
+    h = height;
+    rate = fps;
+    y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    if (y4m) {
+        char header[96];
+        const int n = std::snprintf(header, sizeof header, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n",
+                                    w, h, rate);
+        out.write(header, n);
+        yuv.resize(size_t(w) * h + 2 * size_t((w + 1) / 2) * ((h + 1) / 2));
+    }
+
+    ring.resize(SLOTS);
+    for (Slot& s : ring) s.rgba.resize(size_t(w) * h * 4);
+    head.store(0);
+    tail.store(0);
+    stopping.store(false);
+    written.store(0);
+    bytes.store(0);
+    busyUs.store(0);
+    failed.store(!out);
+    queued = 0;
+    refused = 0;
+    worker = std::thread(&VideoWriter::writerLoop, this);
+    running = true;
+    return true;
+}
+
+bool VideoWriter::finish() {
+    if (!running) return true;
+    stopping.store(true, std::memory_order_release);
+    worker.join();
+    out.close();
+    running = false;
+    return !failed.load() && !out.fail();
+}
+
+bool VideoWriter::push(const uint8_t* rgba, unsigned repeat, bool wait) {
+    if (!running || repeat == 0) return false;
+    const uint64_t next = head.load(std::memory_order_relaxed);
+    while (next - tail.load(std::memory_order_acquire) >= SLOTS) {
+        if (!wait) {
+            ++refused;
+            return false;
+        }
+        std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+    Slot& slot = ring[next % SLOTS];
+    std::memcpy(slot.rgba.data(), rgba, slot.rgba.size());
+    slot.repeat = repeat;
+    head.store(next + 1, std::memory_order_release);
+    queued += repeat;
+    return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Writer thread
+// ─────────────────────────────────────────────────────────────────────────────
+
+// BT.601 full range ("jpeg") in 8-bit fixed point; chroma is the average of
+// each 2x2 block (clamped at an odd edge)
+void VideoWriter::toYuv420(const uint8_t* rgba) {
+    const unsigned cw = (w + 1) / 2, ch = (h + 1) / 2;
+    uint8_t* yPlane = yuv.data();
+    uint8_t* uPlane = yPlane + size_t(w) * h;
+    uint8_t* vPlane = uPlane + size_t(cw) * ch;
+
+    for (unsigned y = 0; y < h; ++y) {
+        const uint8_t* p = rgba + size_t(y) * w * 4;
+        uint8_t* row = yPlane + size_t(y) * w;
+        for (unsigned x = 0; x < w; ++x, p += 4) {
+            row[x] = uint8_t((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+    for (unsigned cy = 0; cy < ch; ++cy) {
+        const unsigned y0 = 2 * cy, y1 = std::min(y0 + 1, h - 1);
+        for (unsigned cx = 0; cx < cw; ++cx) {
+            const unsigned x0 = 2 * cx, x1 = std::min(x0 + 1, w - 1);
+            int r = 0, g = 0, b = 0;
+            for (const unsigned y : { y0, y1 }) {
+                for (const unsigned x : { x0, x1 }) {
+                    const uint8_t* p = rgba + (size_t(y) * w + x) * 4;
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+            }
+            // Sums of four pixels: the extra >> 2 averages them
+            uPlane[size_t(cy) * cw + cx] = uint8_t(128 + ((-43 * r - 85 * g + 128 * b + 512) >> 10));
+            vPlane[size_t(cy) * cw + cx] = uint8_t(128 + ((128 * r - 107 * g - 21 * b + 512) >> 10));
+        }
+    }
+}
+
+void VideoWriter::writerLoop() {
+    static const char FRAME_HEADER[] = "FRAME\n";
+    for (;;) {
+        const uint64_t next = tail.load(std::memory_order_relaxed);
+        if (next == head.load(std::memory_order_acquire)) {
+            // Nothing queued: done if the main thread is too (checked after
+            // the ring was seen empty, so a last push is never left behind)
+            if (stopping.load(std::memory_order_acquire) && next == head.load(std::memory_order_acquire)) break;
+            std::this_thread::sleep_for(IDLE_SLEEP);
+            continue;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const Slot& slot = ring[next % SLOTS];
+        const uint8_t* frame = slot.rgba.data();
+        size_t frameBytes = slot.rgba.size();
+        if (y4m) {
+            toYuv420(slot.rgba.data());
+            frame = yuv.data();
+            frameBytes = yuv.size();
+        }
+        const unsigned repeat = slot.repeat;
+        // The slot's pixels are no longer needed once converted (raw frames
+        // are written straight from the slot, so it is released after)
+        if (y4m) tail.store(next + 1, std::memory_order_release);
+
+        for (unsigned i = 0; i < repeat; ++i) {
+            if (y4m) out.write(FRAME_HEADER, sizeof FRAME_HEADER - 1);
+            out.write(reinterpret_cast<const char*>(frame), std::streamsize(frameBytes));
+        }
+        if (!y4m) tail.store(next + 1, std::memory_order_release);
+        if (!out) failed.store(true);
+
+        written.fetch_add(repeat, std::memory_order_relaxed);
+        bytes.fetch_add(repeat * (frameBytes + (y4m ? sizeof FRAME_HEADER - 1 : 0)), std::memory_order_relaxed);
+        busyUs.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - t0).count()), std::memory_order_relaxed);
+    }
+    out.flush();
+}
@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Video export
+//
+// The render loop hands over each captured frame (RGBA, top row first) and
+// goes straight back to drawing; a writer thread converts and writes it.
+// Frames pass through a fixed ring of SLOTS preallocated buffers shared by
+// exactly one producer (the main thread) and one consumer (the writer), so
+// the hand-over is two atomic counters and a memcpy: no lock, no allocation.
+//
+// Output, picked by the file extension:
+//   .y4m    YUV4MPEG2, 4:2:0 full range (plays in mpv/ffplay, ffmpeg reads it)
+//   other   raw RGBA frames back to back, no header
+//           (ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r FPS -i file ...)
+//
+// A frame can stand for several frames of video (`repeat`), so a live
+// capture keeps to wall-clock time when the game draws slower than the
+// video's rate, and a frame the ring had no room for is made up for by
+// repeating the next one rather than by waiting.
+// ─────────────────────────────────────────────────────────────────────────────
+
+class VideoWriter {
+public:
+    static const size_t SLOTS = 8;
+
+    VideoWriter() = default;
+    ~VideoWriter();                         // writes what is queued, then joins
+
+    VideoWriter(const VideoWriter&) = delete;
+    VideoWriter& operator=(const VideoWriter&) = delete;
+
+    // Opens `path`, writes the header and starts the writer thread
+    bool start(const std::string& path, unsigned width, unsigned height, unsigned fps);
+    // Writes what is queued, closes the file; false if any write failed
+    bool finish();
+
+    bool active() const { return running; }
+    unsigned width() const { return w; }
+    unsigned height() const { return h; }
+    unsigned fps() const { return rate; }
+
+    // Main thread: copies width x height RGBA pixels into the ring. With
+    // `wait` it sleeps until a slot is free (offline export), otherwise it
+    // returns false when the writer is SLOTS frames behind.
+    bool push(const uint8_t* rgba, unsigned repeat, bool wait);
+
+    // Frames of video queued so far (repeats included), and frames the
+    // ring was full for
+    uint64_t framesQueued() const { return queued; }
+    uint64_t framesRefused() const { return refused; }
+    // Writer side, readable from any thread
+    uint64_t framesWritten() const { return written.load(std::memory_order_relaxed); }
+    uint64_t bytesWritten() const { return bytes.load(std::memory_order_relaxed); }
+    double   writerBusyMs() const { return busyUs.load(std::memory_order_relaxed) / 1000.0; }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> rgba;
+        unsigned repeat = 1;
+    };
+
+    void writerLoop();
+    void toYuv420(const uint8_t* rgba);
+
+    unsigned w = 0;
+    unsigned h = 0;
+    unsigned rate = 30;
+    bool     y4m = false;
+    bool     running = false;
+    uint64_t queued = 0;
+    uint64_t refused = 0;
+
+    // The ring: slot i holds frame number i % SLOTS. `head` is only written
+    // by the main thread (frames pushed), `tail` only by the writer (frames
+    // done), so each side reads the other's counter and never blocks.
+    std::vector<Slot>     ring;
+    std::atomic<uint64_t> head{ 0 };
+    std::atomic<uint64_t> tail{ 0 };
+    std::atomic<bool>     stopping{ false };
+
+    // Writer thread only
+    std::thread           worker;
+    std::ofstream         out;
+    std::vector<uint8_t>  yuv;
+    std::atomic<uint64_t> written{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint64_t> busyUs{ 0 };
+    std::atomic<bool>     failed{ false };
+};